@@ -0,0 +1,300 @@
+/*****************************************************************************
+ * clip_perfcheck - end-to-end regression gate for the clip binary           *
+ * Generates a miniature synthetic archive (scenes + MTLs + mask) on first   *
+ * run, executes bin/clip on it, asserts byte-identical outputs against      *
+ * golden copies, and enforces wall/RSS/bytes budgets. Results go to         *
+ * perfcheck/results.json for dashboard trending. Build with                 *
+ * `make perfcheck`; exits nonzero on any regression.                        *
+ *****************************************************************************/
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "utils.hpp"
+
+#include "gdal_priv.h"
+#include "ogrsf_frmts.h"
+
+using Clock = std::chrono::steady_clock;
+
+// ---------- Budgets ----------------------------------------------------------
+// Generous on purpose: they catch order-of-magnitude regressions, not
+// machine-to-machine noise. Tighten once dashboards have a baseline.
+static const double MAX_WALL_S = 30.0;
+static const long MAX_RSS_MB = 768;
+static const long long MAX_WRITE_MB = 64;
+
+static const int NUM_SCENES = 4;
+static const int SCENE_SIZE = 512;
+
+// ---------- Synthetic archive ------------------------------------------------
+
+static std::string sceneName(int i) {
+    char name[64];
+    snprintf(name, sizeof(name), "LC08_L2SP_021047_2025%04d_20251001_02_T1", i);
+    return name;
+}
+
+static bool makeBand(const std::string &dir, int i, const char *suffix) {
+    GDALDriver *drv = (GDALDriver*)GDALGetDriverByName("GTiff");
+    if (!drv) return false;
+
+    std::string path = dir + "/" + sceneName(i) + "_" + suffix + ".tif";
+    GDALDataset *ds = drv->Create(path.c_str(), SCENE_SIZE, SCENE_SIZE, 1,
+                                  GDT_UInt16, nullptr);
+    if (!ds) return false;
+
+    // All scenes share one 30 m grid so every clip window is identical
+    double gt[6] = { 500000.0, 30.0, 0.0, 3000000.0, 0.0, -30.0 };
+    ds->SetGeoTransform(gt);
+    std::string wkt = getWKTFromEPSG(32615);
+    if (!wkt.empty()) ds->SetProjection(wkt.c_str());
+
+    // Deterministic fill: depends only on position, scene and band.
+    // suffix[4] is the band digit ('4'/'5'), so the two bands of a
+    // scene differ and a swapped or cross-wired band input fails the
+    // golden comparison
+    std::vector<unsigned short> row(SCENE_SIZE);
+    GDALRasterBand *band = ds->GetRasterBand(1);
+    for (int y = 0; y < SCENE_SIZE; ++y) {
+        for (int x = 0; x < SCENE_SIZE; ++x) {
+            row[x] = (unsigned short)(x + y * 7 + i * 131 + suffix[4] * 997);
+        }
+        if (band->RasterIO(GF_Write, 0, y, SCENE_SIZE, 1, row.data(),
+                           SCENE_SIZE, 1, GDT_UInt16, 0, 0, nullptr) != CE_None) {
+            GDALClose(ds);
+            return false;
+        }
+    }
+    GDALClose(ds);
+    return true;
+}
+
+static bool makeScene(const std::string &dir, int i) {
+    if (!makeBand(dir, i, "SR_B4") || !makeBand(dir, i, "SR_B5")) {
+        return false;
+    }
+    std::string mtlPath = dir + "/" + sceneName(i) + "_MTL.txt";
+    FILE *mtl = fopen(mtlPath.c_str(), "w");
+    if (!mtl) return false;
+    fprintf(mtl, "GROUP = PROJECTION_ATTRIBUTES\n");
+    fprintf(mtl, "    MAP_PROJECTION = \"UTM\"\n");
+    fprintf(mtl, "    UTM_ZONE = 15\n");
+    fprintf(mtl, "END_GROUP = PROJECTION_ATTRIBUTES\n");
+    fclose(mtl);
+    return true;
+}
+
+static bool makeMask(const std::string &shpPath) {
+    GDALDriver *drv = (GDALDriver*)GDALGetDriverByName("ESRI Shapefile");
+    if (!drv) return false;
+
+    GDALDataset *ds = drv->Create(shpPath.c_str(), 0, 0, 0, GDT_Unknown, nullptr);
+    if (!ds) return false;
+
+    OGRLayer *layer = ds->CreateLayer("mask", nullptr, wkbPolygon, nullptr);
+    if (!layer) {
+        GDALClose(ds);
+        return false;
+    }
+
+    // Central block of the shared scene grid
+    OGRLinearRing ring;
+    ring.addPoint(503000.0, 2992000.0);
+    ring.addPoint(508000.0, 2992000.0);
+    ring.addPoint(508000.0, 2997000.0);
+    ring.addPoint(503000.0, 2997000.0);
+    ring.addPoint(503000.0, 2992000.0);
+    OGRPolygon poly;
+    poly.addRing(&ring);
+
+    OGRFeature *feat = OGRFeature::CreateFeature(layer->GetLayerDefn());
+    feat->SetGeometry(&poly);
+    layer->CreateFeature(feat);
+    OGRFeature::DestroyFeature(feat);
+
+    GDALClose(ds);
+    return true;
+}
+
+// ---------- File helpers -----------------------------------------------------
+
+static bool readFileBytes(const std::string &path, std::vector<char> &bytes) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) return false;
+    std::streamsize size = in.tellg();
+    in.seekg(0);
+    bytes.resize((size_t)size);
+    return size == 0 || (bool)in.read(bytes.data(), size);
+}
+
+static bool copyFileBytes(const std::string &from, const std::string &to) {
+    std::vector<char> bytes;
+    if (!readFileBytes(from, bytes)) return false;
+    std::ofstream out(to, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) return false;
+    return bytes.empty() || (bool)out.write(bytes.data(), bytes.size());
+}
+
+static long long fileSize(const std::string &path) {
+    struct stat st;
+    return (stat(path.c_str(), &st) == 0) ? (long long)st.st_size : 0;
+}
+
+// Sorted *.tif names in a directory
+static std::vector<std::string> tifsIn(const std::string &dir) {
+    std::vector<std::string> tifs;
+    for (const std::string &name : listFilesInDirectory(dir)) {
+        if (ends_with(name, ".tif")) tifs.push_back(name);
+    }
+    std::sort(tifs.begin(), tifs.end());
+    return tifs;
+}
+
+// ---------- The check --------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    std::string clip_bin = (argc > 1) ? argv[1] : "bin/clip";
+    std::string root = "perfcheck";
+    std::string archive = root + "/archive";
+    std::string out = root + "/out";
+    std::string golden = root + "/golden";
+    std::string mask = archive + "/mask.shp";
+
+    mkdir(root.c_str(), 0755);
+    mkdir(archive.c_str(), 0755);
+    mkdir(out.c_str(), 0755);
+    mkdir(golden.c_str(), 0755);
+
+    GDALAllRegister();
+
+    // Generate the miniature archive once; later runs reuse it so the
+    // goldens stay meaningful
+    if (tifsIn(archive).empty()) {
+        std::cout << "Generating synthetic archive (" << NUM_SCENES
+                  << " scenes, " << SCENE_SIZE << "px)...\n";
+        for (int i = 0; i < NUM_SCENES; ++i) {
+            if (!makeScene(archive, i)) {
+                std::cerr << "ERROR: Cannot generate scene " << i << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+        if (!makeMask(mask)) {
+            std::cerr << "ERROR: Cannot generate mask\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Fresh outputs every run: stale files would hide write regressions
+    for (const std::string &name : tifsIn(out)) {
+        unlink((out + "/" + name).c_str());
+    }
+    unlink((out + "/.clip_manifest").c_str());
+    unlink((archive + "/.clip_catalog").c_str());
+
+    // Run the real binary the way production does
+    std::vector<std::string> args = {
+        clip_bin, "-i", archive, "-o", out, "-c", "EPSG:32615",
+        "-m", mask, "-d", "SR_B4,SR_B5", "-j", "2", "-q"
+    };
+    std::vector<char*> argp;
+    for (std::string &a : args) argp.push_back(&a[0]);
+    argp.push_back(nullptr);
+
+    Clock::time_point start = Clock::now();
+    pid_t pid = fork();
+    if (pid == 0) {
+        execv(clip_bin.c_str(), argp.data());
+        perror("execv");
+        _exit(127);
+    }
+    int status = 0;
+    struct rusage ru;
+    memset(&ru, 0, sizeof(ru));
+    wait4(pid, &status, 0, &ru);
+    double wall_s = std::chrono::duration<double>(Clock::now() - start).count();
+
+    bool run_ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    long rss_mb = ru.ru_maxrss / 1024;  // ru_maxrss is in KB on Linux
+
+    // Outputs and byte totals
+    std::vector<std::string> outputs = tifsIn(out);
+    long long bytes_written = 0;
+    for (const std::string &name : outputs) {
+        bytes_written += fileSize(out + "/" + name);
+    }
+
+    // Golden comparison: first run records the goldens, later runs must
+    // reproduce them byte for byte
+    bool golden_created = false;
+    bool golden_match = true;
+    std::vector<std::string> goldens = tifsIn(golden);
+    if (goldens.empty()) {
+        for (const std::string &name : outputs) {
+            if (!copyFileBytes(out + "/" + name, golden + "/" + name)) {
+                std::cerr << "ERROR: Cannot record golden: " << name << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+        golden_created = true;
+    } else {
+        if (goldens != outputs) {
+            std::cerr << "FAIL: Output file set differs from goldens ("
+                      << outputs.size() << " vs " << goldens.size() << ")\n";
+            golden_match = false;
+        } else {
+            for (const std::string &name : outputs) {
+                std::vector<char> got, want;
+                if (!readFileBytes(out + "/" + name, got) ||
+                    !readFileBytes(golden + "/" + name, want) ||
+                    got != want) {
+                    std::cerr << "FAIL: Output differs from golden: "
+                              << name << "\n";
+                    golden_match = false;
+                }
+            }
+        }
+    }
+
+    bool pass = run_ok && golden_match &&
+                !outputs.empty() &&
+                wall_s <= MAX_WALL_S &&
+                rss_mb <= MAX_RSS_MB &&
+                bytes_written <= MAX_WRITE_MB * 1024 * 1024;
+
+    // Machine-readable result, one JSON object per run
+    char json[512];
+    snprintf(json, sizeof(json),
+             "{\"pass\": %s, \"run_ok\": %s, \"golden_match\": %s, "
+             "\"golden_created\": %s, \"outputs\": %zu, "
+             "\"wall_s\": %.3f, \"max_rss_mb\": %ld, "
+             "\"bytes_written\": %lld, "
+             "\"budget\": {\"wall_s\": %.1f, \"max_rss_mb\": %ld, "
+             "\"bytes_written\": %lld}}",
+             pass ? "true" : "false", run_ok ? "true" : "false",
+             golden_match ? "true" : "false",
+             golden_created ? "true" : "false", outputs.size(),
+             wall_s, rss_mb, bytes_written,
+             MAX_WALL_S, MAX_RSS_MB, MAX_WRITE_MB * 1024LL * 1024LL);
+
+    std::ofstream results(root + "/results.json", std::ios::trunc);
+    if (results.is_open()) {
+        results << json << "\n";
+    }
+    std::cout << json << "\n";
+    std::cout << (pass ? "perfcheck: PASS" : "perfcheck: FAIL") << std::endl;
+
+    return pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Persistent scene catalog: a small binary file (.clip_catalog) written
+// into the input directory after a full scan, listing every *.tif with
+// its size, mtime and the UTM zone probed from the scene's MTL file.
+// Subsequent runs memory-map the catalog instead of re-walking the
+// directory tree and re-opening MTL files; it is trusted only while the
+// mtimes of the scanned directories are unchanged, so adding or
+// removing files invalidates it automatically.
+
+// Fills tifNames (paths relative to dirPath, like the scanners return)
+// from a valid catalog. Returns false if there is no catalog, it is
+// stale, or it was built with a different scan mode (recursive vs not);
+// in all those cases the caller scans and rebuilds.
+bool sceneCatalogLoad(const std::string& dirPath, bool recursive,
+                      std::vector<std::string>& tifNames);
+
+// Builds and writes the catalog from a freshly scanned file list,
+// probing each scene's MTL for its UTM zone. scannedDirs are the
+// directories the walk entered (relative to dirPath), whose mtimes
+// guard the catalog alongside dirPath itself. Best effort: a read-only
+// archive simply gets no catalog.
+void sceneCatalogBuild(const std::string& dirPath,
+                       const std::vector<std::string>& tifNames,
+                       bool recursive,
+                       const std::vector<std::string>& scannedDirs);
+
+// UTM zone for a band file from the loaded catalog, skipping the MTL
+// probe entirely. Returns false if no valid catalog covers the file.
+bool sceneCatalogZone(const std::string& dirPath,
+                      const std::string& tifFilename, int& utmZone);
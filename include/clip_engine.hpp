@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Streaming windowed clip: computes the pixel window of the bbox once
+// from the source geotransform, then copies block-aligned chunks of rows
+// with RasterIO into the output, reusing one per-thread buffer. Same
+// grid and resolution as the source, no resampling. Falls back to the
+// GDALTranslate path (clipRasterByBBox) for rotated/exotic geotransforms.
+bool clipRasterWindowed(const std::string& inFile,
+                        const std::string& outFile,
+                        double minX, double minY,
+                        double maxX, double maxY,
+                        int epsgCode);
+
+// Clip several single-band files of one scene into one multi-band output
+// (--stack), reusing the same pixel window and buffer for every band.
+// All inputs must share the grid of the first file.
+bool clipRasterStack(const std::vector<std::string>& inFiles,
+                     const std::string& outFile,
+                     double minX, double minY,
+                     double maxX, double maxY,
+                     int epsgCode);
+
+// Enable exact polygon masking (--mask-exact): the shapefile polygon is
+// rasterized once per distinct pixel window into a cached bitmask, and
+// pixels outside the polygon are set to the band nodata (or 0) during
+// the clip, before writing. Pass an empty string to disable.
+void setExactMask(const std::string& shpFile);
+
+// GeoTIFF creation options (KEY=VALUE) applied to every output the
+// engine creates. Set once before dispatching workers.
+void setCreationOptions(const std::vector<std::string>& options);
+
+// Target-aligned pixels (--tap): snap the clip bbox outward to
+// multiples of each source's pixel size before deriving the integer
+// window. All scenes sharing a grid convention then get the identical
+// window and output block layout, so stacked or mosaicked outputs line
+// up without resampling. 30 m snapping nests exactly in the 15 m B8
+// grid.
+void setTargetAlignedPixels(bool enable);
+
+// Reduced-resolution output (--outsize): outputs are percent% of the
+// clip window size, average-resampled during the windowed read. GDAL
+// reads from a source overview level when one is close enough, so
+// quicklook generation skips most of the base-raster I/O. 100 = full
+// resolution (default).
+void setOutputScale(int percent);
+
+// Tune GDAL's curl-backed virtual filesystems for windowed reads from
+// object storage (merged range requests, no per-open directory probe,
+// range cache). Call once before clipping when inputs are /vsi paths.
+void configureRemoteIO();
+
+// Size of GDAL's raster block cache, in MB (--cache-mb)
+void setClipCacheBudget(int cacheMB);
+
+// Global memory budget in MB (--mem-limit): each clip reserves its
+// estimated footprint (window pixels x dtype) before running and blocks
+// until it fits, and whole-window buffers above the budget's share are
+// streamed in block rows instead. Keeps RSS predictable under N-way
+// parallelism in cgroup-limited batch environments. 0 disables.
+void setMemoryBudget(int memMB);
+
+// Max number of idle source datasets kept open in the handle pool, so
+// consecutive clips of the same file reuse the handle and its cached
+// blocks instead of reopening. 0 disables pooling.
+void setDatasetPoolCapacity(size_t maxOpen);
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Bounding box in map units (same CRS as the rasters being clipped)
+struct BBox {
+    double minX = 0.0;
+    double minY = 0.0;
+    double maxX = 0.0;
+    double maxY = 0.0;
+};
+
+// Reusable in-process clip pipeline. Construction registers the GDAL/OGR
+// drivers once per process (safe to create several sessions), loadMask()
+// reads and caches the mask extent once, and clip() can then be called
+// thousands of times from the same process without paying driver
+// registration or shapefile reads again. clip() is safe to call from
+// several worker threads on the same session.
+class ClipSession {
+public:
+    ClipSession();
+
+    // Read the mask shapefile extent, inflate it by 'margin' map units on
+    // every side, and cache it for all later clip() calls.
+    bool loadMask(const std::string &shpFile, double margin = 0.0);
+
+    // Cached clip extent
+    void setBBox(const BBox &box);
+    BBox getBBox() const;
+
+    // Default EPSG code used by clip() when no per-file code is given
+    void setEPSG(int epsgCode);
+    int getEPSG() const;
+
+    // Clip one raster to the cached extent
+    bool clip(const std::string &inFile, const std::string &outFile) const;
+    bool clip(const std::string &inFile, const std::string &outFile,
+              int epsgCode) const;
+
+    // Clip several band files of one scene into one multi-band output
+    bool clipStack(const std::vector<std::string> &inFiles,
+                   const std::string &outFile, int epsgCode) const;
+
+private:
+    BBox bbox;
+    int epsg_code;
+};
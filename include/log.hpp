@@ -0,0 +1,27 @@
+#pragma once
+
+#include <iostream>
+
+// Leveled, buffered logging. Errors always go to std::cerr; everything
+// else goes through LOG(level), which skips the whole stream expression
+// (no formatting work at all) when the level is above the active one.
+//   LOG_QUIET   --quiet: only errors and the final summary
+//   LOG_NORMAL  default: per-file progress lines
+//   LOG_VERBOSE --debug: extra per-file detail
+enum LogLevel {
+    LOG_QUIET = 0,
+    LOG_NORMAL = 1,
+    LOG_VERBOSE = 2
+};
+
+// Sets the level and switches stdout to a large full buffer, so the
+// remaining per-file lines don't flush line-by-line into the scheduler's
+// log capture
+void logSetLevel(LogLevel level);
+LogLevel logGetLevel();
+
+// Flush buffered log output (call before printing final summaries)
+void logFlush();
+
+// Inverted if/else so the macro nests safely under an unbraced if
+#define LOG(level) if ((level) > logGetLevel()) ; else std::cout
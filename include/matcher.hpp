@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Filename matcher compiled once per run for the --pattern filter.
+// Pattern syntax (a superset of the old "substring anywhere" behavior):
+//   foo        matches names containing "foo"
+//   ^foo       anchored: names starting with "foo"
+//   foo$       anchored: names ending with "foo"
+//   a|b|c      alternatives, matched in one pass over the name
+// An empty pattern matches everything. The scan itself runs on
+// memchr/memcmp, whose libc implementations are vectorized, instead of
+// constructing std::strings and calling string::find per candidate.
+class FileMatcher {
+public:
+    // Compiles the pattern; call once, then matches() from any thread.
+    void compile(std::string_view pattern);
+
+    bool empty() const { return alts.empty(); }
+
+    bool matches(std::string_view name) const;
+
+private:
+    struct Alternative {
+        std::string needle;
+        bool anchor_start = false;
+        bool anchor_end = false;
+    };
+    std::vector<Alternative> alts;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <string_view>
+
+// Parsed Landsat MTL metadata file. The whole file is slurped into one
+// buffer and tokenized into KEY = VALUE pairs in a single pass; the
+// table maps key views to value views into that buffer, so parsing does
+// no per-line allocation and lookups are cheap. GROUP/END_GROUP nesting
+// is flattened: MTL keys are unique across groups in practice, and the
+// first occurrence wins.
+class MTLFile {
+public:
+    // Reads and parses the file. Returns false if it cannot be opened;
+    // an unparseable line is skipped, not fatal.
+    bool load(const std::string& path);
+
+    bool valid() const { return loaded; }
+
+    // Typed accessors; each returns false when the key is absent (or,
+    // for the numeric ones, when the value does not parse). String
+    // values have surrounding quotes stripped.
+    bool getString(std::string_view key, std::string& value) const;
+    bool getInt(std::string_view key, int& value) const;
+    bool getDouble(std::string_view key, double& value) const;
+
+private:
+    bool loaded = false;
+    std::string buffer;  // the file's bytes; the views below alias it
+    std::map<std::string_view, std::string_view, std::less<>> values;
+};
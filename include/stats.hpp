@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+
+// Lightweight per-stage instrumentation, enabled by --stats. When
+// disabled, a ScopedTimer costs one clock read and one branch; the
+// byte counters cost one branch. Aggregation (count, total, mean, p95
+// per stage, bytes moved) is printed once at the end with statsReport().
+void statsEnable(bool on);
+bool statsEnabled();
+
+void statsRecord(const char *stage, double seconds);
+void statsAddBytesRead(unsigned long long bytes);
+void statsAddBytesWritten(unsigned long long bytes);
+
+void statsReport();
+
+// Times one stage for the lifetime of the scope
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const char *stageName)
+        : stage(stageName), start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedTimer() {
+        if (statsEnabled()) {
+            std::chrono::duration<double> elapsed =
+                std::chrono::steady_clock::now() - start;
+            statsRecord(stage, elapsed.count());
+        }
+    }
+
+private:
+    const char *stage;
+    std::chrono::steady_clock::time_point start;
+};
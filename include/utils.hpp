@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <map>
 
@@ -13,20 +14,64 @@ struct PathParts {
     std::string extension;  // extension (with leading dot, if any)
 };
 
+// Allocation-free variant for hot loops: the views alias the input
+// string, which must outlive them
+struct PathPartsView {
+    std::string_view directory;
+    std::string_view basename;
+    std::string_view stem;
+    std::string_view extension;
+};
+
 void print_help();
 void print_version(const std::string &version, const std::string &date);
 std::vector<std::string> split_by_commas(const std::string &);
 std::vector<int> string_to_int(const std::vector<std::string> &);
 PathParts splitPath(const std::string& );
+PathPartsView splitPathView(std::string_view path);
 bool directory_exists(const std::string&);
-bool ends_with(const std::string &, const std::string &);
-bool find_pattern(const std::string&, const std::string&);
+bool isVSIPath(std::string_view path);
+bool ends_with(std::string_view, std::string_view);
+bool find_pattern(std::string_view, std::string_view);
 std::vector<std::string> listFilesInDirectory(const std::string& dirPath);
+
+// Per-band file index built in one directory pass: *.tif files grouped by
+// their band suffix (the part of the stem after the Landsat scene ID)
+struct FileIndex {
+    // Transparent comparator so the build loop can look up by
+    // string_view without materializing a key per file
+    std::map<std::string, std::vector<std::string>, std::less<>> bySuffix;
+};
+
+// scannedDirs, when given, receives every directory the walk entered
+// (relative to dirPath, "" for the root), for the catalog mtime guard
+std::vector<std::string> listFilesRecursive(const std::string& dirPath,
+                                            unsigned int numThreads,
+                                            std::vector<std::string>* scannedDirs = nullptr);
+FileIndex buildFileIndex(const std::string& dirPath, const std::string& pattern,
+                         bool recursive = false, unsigned int scanThreads = 1);
+std::vector<std::string> filesForBand(const FileIndex& index, const std::string& band);
 bool fileExists(const std::string& filename);
+// File size in bytes for local or /vsi paths, -1 when it cannot be
+// stat'ed (used for the worker pool's byte-cost hints)
+long long getFileSize(const std::string& path);
+bool outputUpToDate(const std::string& inFile, const std::string& outFile);
+bool readClipManifest(const std::string& manifestFile,
+                      double &minX, double &minY,
+                      double &maxX, double &maxY,
+                      int &epsgCode);
+bool writeClipManifest(const std::string& manifestFile,
+                       double minX, double minY,
+                       double maxX, double maxY,
+                       int epsgCode);
 std::string locateMetadataFile(const std::string& dirPath, const std::string& tifFilename);
 bool extractProjectionInfo(const std::string& filename, std::string& projection, int& utmZone);
+bool getSceneProjectionInfo(const std::string& dirPath,
+                            const std::string& tifFilename,
+                            std::string& projection, int& utmZone);
 std::string stripString(const std::string& input);
 std::string getEPSGFromUTMZone(int zone, bool isSouthernHemisphere = false);
+std::string getWKTFromEPSG(int epsgCode);
 bool clipRasterByBBox(const std::string& inFile,
                       const std::string& outFile,
                       double minX, double minY,
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size worker pool with work stealing. All tasks are queued up
+// front with addTask(), then run() spawns N threads and joins them.
+// Each task must own its private state (e.g. its own GDAL dataset
+// handles); the pool only serializes access to the task deques.
+//
+// Tasks can carry a cost hint (typically the input file's size in
+// bytes). run() pre-assigns tasks to per-worker deques, largest first,
+// so the initial split is balanced by bytes rather than by count; a
+// worker that drains its own deque steals from the back of whichever
+// worker has the most outstanding work. This keeps everyone busy when
+// task sizes are wildly uneven (a 15m B8 clip is ~4x a 30m band clip).
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned int numWorkers);
+
+    // Queue a task with an optional cost hint in arbitrary units
+    // (0 = unknown). Must not be called after run() has started.
+    void addTask(std::function<void()> task, size_t costHint = 0);
+
+    // Number of tasks currently queued.
+    size_t pendingTasks();
+
+    // Run all queued tasks on the workers, blocking until every task
+    // has finished.
+    void run();
+
+private:
+    struct Task {
+        std::function<void()> fn;
+        size_t cost;
+    };
+
+    void workerLoop(unsigned int id);
+
+    unsigned int num_workers;
+    std::vector<std::thread> workers;
+    std::vector<Task> tasks;  // staging area until run()
+
+    // Per-worker state, built by run(). Tasks are whole-file clips
+    // (milliseconds at minimum), so one mutex over all deques is cheap
+    // and keeps the stealing logic simple.
+    std::vector<std::deque<Task>> worker_tasks;
+    std::vector<size_t> worker_cost;  // outstanding cost per worker
+    std::mutex queue_mutex;
+};
@@ -0,0 +1,327 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+
+#include "catalog.hpp"
+#include "utils.hpp"
+
+// On-disk layout (native endianness; the catalog lives next to the data
+// it describes, so it is rebuilt rather than shared across machines):
+//   magic   8 bytes  "CLIPCAT2"
+//   u8      1 if the scan was recursive, 0 otherwise
+//   u32     number of scanned directories
+//   per dir:   u16 path length, path bytes, i64 mtime
+//   u32     number of entries
+//   per entry: u16 path length, path bytes (relative to the input dir),
+//              i64 size, i64 mtime, i32 utm zone (0 = no MTL)
+static const char CATALOG_MAGIC[8] = {'C','L','I','P','C','A','T','2'};
+
+namespace {
+struct CatalogEntry {
+    std::string path;
+    long long size = 0;
+    long long mtime = 0;
+    int utmZone = 0;
+};
+
+struct LoadedCatalog {
+    bool attempted = false;
+    bool valid = false;
+    bool recursive = false;  // scan mode the catalog was built with
+    std::vector<CatalogEntry> entries;
+    std::map<std::string, int> zoneByScene;  // sceneDir + "/" + sceneId
+};
+} // namespace
+
+static std::map<std::string, LoadedCatalog> catalog_cache;
+static std::mutex catalog_mutex;
+
+static std::string catalogFilePath(const std::string& dirPath) {
+    std::string path = dirPath;
+    if (path.back() != '/') path += "/";
+    return path + ".clip_catalog";
+}
+
+static std::string joinPath(const std::string& dirPath, const std::string& name) {
+    if (dirPath.back() != '/') {
+        return dirPath + "/" + name;
+    }
+    return dirPath + name;
+}
+
+// Bounds-checked readers over the mapped file
+static bool readBytes(const char*& cur, const char* end, void* out, size_t n) {
+    if ((size_t)(end - cur) < n) return false;
+    memcpy(out, cur, n);
+    cur += n;
+    return true;
+}
+
+static bool readString(const char*& cur, const char* end, std::string& out) {
+    uint16_t len = 0;
+    if (!readBytes(cur, end, &len, sizeof(len))) return false;
+    if ((size_t)(end - cur) < len) return false;
+    out.assign(cur, len);
+    cur += len;
+    return true;
+}
+
+static void sceneKeyFor(const std::string& dirPath, const std::string& tifName,
+                        std::string& key) {
+    // Mirror the keying in getSceneProjectionInfo(): the MTL sits next
+    // to the band file, and the scene ID is the 40-char basename prefix
+    PathParts parts = splitPath(tifName);
+    std::string sceneDir = dirPath;
+    if (!parts.directory.empty()) {
+        if (sceneDir.back() != '/') sceneDir += "/";
+        sceneDir += parts.directory;
+    }
+    key = sceneDir + "/" + parts.basename.substr(0, 40);
+}
+
+static bool loadFromDisk(const std::string& dirPath, LoadedCatalog& cat) {
+    std::string file = catalogFilePath(dirPath);
+
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(CATALOG_MAGIC)) {
+        close(fd);
+        return false;
+    }
+    void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    const char *cur = (const char*)map;
+    const char *end = cur + st.st_size;
+    bool ok = false;
+
+    do {
+        char magic[8];
+        if (!readBytes(cur, end, magic, sizeof(magic))) break;
+        if (memcmp(magic, CATALOG_MAGIC, sizeof(magic)) != 0) break;
+
+        uint8_t recursive = 0;
+        if (!readBytes(cur, end, &recursive, sizeof(recursive))) break;
+        cat.recursive = (recursive != 0);
+
+        // The catalog is only trusted while every scanned directory has
+        // the mtime it had when the catalog was written; adding or
+        // removing a file bumps its parent's mtime and forces a rescan
+        uint32_t dir_count = 0;
+        if (!readBytes(cur, end, &dir_count, sizeof(dir_count))) break;
+        bool dirs_ok = true;
+        for (uint32_t i = 0; i < dir_count; ++i) {
+            std::string dir;
+            int64_t mtime = 0;
+            if (!readString(cur, end, dir) ||
+                !readBytes(cur, end, &mtime, sizeof(mtime))) {
+                dirs_ok = false;
+                break;
+            }
+            struct stat dst;
+            if (stat(dir.c_str(), &dst) != 0 || (int64_t)dst.st_mtime != mtime) {
+                dirs_ok = false;
+                break;
+            }
+        }
+        if (!dirs_ok) break;
+
+        uint32_t entry_count = 0;
+        if (!readBytes(cur, end, &entry_count, sizeof(entry_count))) break;
+        cat.entries.reserve(entry_count);
+        bool entries_ok = true;
+        for (uint32_t i = 0; i < entry_count; ++i) {
+            CatalogEntry entry;
+            int64_t size = 0, mtime = 0;
+            int32_t zone = 0;
+            if (!readString(cur, end, entry.path) ||
+                !readBytes(cur, end, &size, sizeof(size)) ||
+                !readBytes(cur, end, &mtime, sizeof(mtime)) ||
+                !readBytes(cur, end, &zone, sizeof(zone))) {
+                entries_ok = false;
+                break;
+            }
+            entry.size = size;
+            entry.mtime = mtime;
+            entry.utmZone = zone;
+
+            if (zone > 0) {
+                std::string key;
+                sceneKeyFor(dirPath, entry.path, key);
+                cat.zoneByScene[key] = zone;
+            }
+            cat.entries.push_back(std::move(entry));
+        }
+        ok = entries_ok;
+    } while (false);
+
+    munmap(map, st.st_size);
+    if (!ok) {
+        cat.entries.clear();
+        cat.zoneByScene.clear();
+    }
+    return ok;
+}
+
+// Returns the per-directory cache slot, loading the catalog from disk on
+// first use. Caller must hold catalog_mutex.
+static LoadedCatalog& getCatalog(const std::string& dirPath) {
+    LoadedCatalog &cat = catalog_cache[dirPath];
+    if (!cat.attempted) {
+        cat.attempted = true;
+        cat.valid = loadFromDisk(dirPath, cat);
+    }
+    return cat;
+}
+
+bool sceneCatalogLoad(const std::string& dirPath, bool recursive,
+                      std::vector<std::string>& tifNames) {
+    std::lock_guard<std::mutex> lock(catalog_mutex);
+    LoadedCatalog &cat = getCatalog(dirPath);
+    if (!cat.valid) {
+        return false;
+    }
+    // A catalog built by a non-recursive scan knows nothing about the
+    // subtree (and vice versa); serving it to the other mode would
+    // silently hide files, so force a rescan instead
+    if (cat.recursive != recursive) {
+        return false;
+    }
+    tifNames.clear();
+    tifNames.reserve(cat.entries.size());
+    for (const CatalogEntry &entry : cat.entries) {
+        tifNames.push_back(entry.path);
+    }
+    return true;
+}
+
+void sceneCatalogBuild(const std::string& dirPath,
+                       const std::vector<std::string>& tifNames,
+                       bool recursive,
+                       const std::vector<std::string>& scannedDirs) {
+    std::vector<CatalogEntry> entries;
+    entries.reserve(tifNames.size());
+
+    // The scanned directories whose mtimes guard the catalog: the input
+    // directory itself plus every directory the walk entered — including
+    // intermediate levels that hold no files directly, since a new scene
+    // directory bumps only its parent's mtime
+    std::set<std::string> dirs;
+    dirs.insert(dirPath);
+    for (const std::string &rel : scannedDirs) {
+        if (!rel.empty()) {
+            dirs.insert(joinPath(dirPath, rel));
+        }
+    }
+
+    for (const std::string &name : tifNames) {
+        CatalogEntry entry;
+        entry.path = name;
+
+        struct stat st;
+        if (stat(joinPath(dirPath, name).c_str(), &st) == 0) {
+            entry.size = st.st_size;
+            entry.mtime = st.st_mtime;
+        }
+
+        PathParts parts = splitPath(name);
+        if (!parts.directory.empty()) {
+            dirs.insert(joinPath(dirPath, parts.directory));
+        }
+
+        // One MTL probe per scene (getSceneProjectionInfo caches), the
+        // result is baked into the catalog so later runs skip it
+        std::string projection;
+        int zone = 0;
+        if (getSceneProjectionInfo(dirPath, name, projection, zone)) {
+            entry.utmZone = zone;
+        }
+
+        entries.push_back(std::move(entry));
+    }
+
+    std::ofstream out(catalogFilePath(dirPath),
+                      std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        return;  // read-only archive, no catalog
+    }
+
+    out.write(CATALOG_MAGIC, sizeof(CATALOG_MAGIC));
+
+    uint8_t recursive_flag = recursive ? 1 : 0;
+    out.write((const char*)&recursive_flag, sizeof(recursive_flag));
+
+    uint32_t dir_count = (uint32_t)dirs.size();
+    out.write((const char*)&dir_count, sizeof(dir_count));
+    for (const std::string &dir : dirs) {
+        uint16_t len = (uint16_t)dir.size();
+        struct stat st;
+        int64_t mtime = (stat(dir.c_str(), &st) == 0) ? (int64_t)st.st_mtime : 0;
+        out.write((const char*)&len, sizeof(len));
+        out.write(dir.data(), len);
+        out.write((const char*)&mtime, sizeof(mtime));
+    }
+
+    uint32_t entry_count = (uint32_t)entries.size();
+    out.write((const char*)&entry_count, sizeof(entry_count));
+    for (const CatalogEntry &entry : entries) {
+        uint16_t len = (uint16_t)entry.path.size();
+        int64_t size = entry.size;
+        int64_t mtime = entry.mtime;
+        int32_t zone = entry.utmZone;
+        out.write((const char*)&len, sizeof(len));
+        out.write(entry.path.data(), len);
+        out.write((const char*)&size, sizeof(size));
+        out.write((const char*)&mtime, sizeof(mtime));
+        out.write((const char*)&zone, sizeof(zone));
+    }
+    out.close();
+
+    // Note: writing the catalog bumps the input directory's mtime, so
+    // record the cached state in memory and let the next process load it
+    // from disk (the stored mtime is re-read above, after the write)
+    std::lock_guard<std::mutex> lock(catalog_mutex);
+    LoadedCatalog &cat = catalog_cache[dirPath];
+    cat.attempted = true;
+    cat.valid = true;
+    cat.recursive = recursive;
+    cat.entries = std::move(entries);
+    cat.zoneByScene.clear();
+    for (const CatalogEntry &entry : cat.entries) {
+        if (entry.utmZone > 0) {
+            std::string key;
+            sceneKeyFor(dirPath, entry.path, key);
+            cat.zoneByScene[key] = entry.utmZone;
+        }
+    }
+}
+
+bool sceneCatalogZone(const std::string& dirPath,
+                      const std::string& tifFilename, int& utmZone) {
+    std::lock_guard<std::mutex> lock(catalog_mutex);
+    LoadedCatalog &cat = getCatalog(dirPath);
+    if (!cat.valid) {
+        return false;
+    }
+    std::string key;
+    sceneKeyFor(dirPath, tifFilename, key);
+    auto it = cat.zoneByScene.find(key);
+    if (it == cat.zoneByScene.end()) {
+        return false;
+    }
+    utmZone = it->second;
+    return true;
+}
@@ -0,0 +1,974 @@
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "clip_engine.hpp"
+#include "stats.hpp"
+#include "utils.hpp"
+
+#include "cpl_conv.h"
+#include "gdal_alg.h"
+#include "ogrsf_frmts.h"
+
+// Output creation options (--co / --profile). Set once before the
+// workers start, read-only afterwards, so no locking in the hot path.
+static std::vector<std::string> creation_options;
+static std::vector<char*> creation_option_ptrs;
+
+void setCreationOptions(const std::vector<std::string>& options) {
+    creation_options = options;
+    creation_option_ptrs.clear();
+    for (auto &opt : creation_options) {
+        creation_option_ptrs.push_back(&opt[0]);
+    }
+    creation_option_ptrs.push_back(nullptr);
+}
+
+static char **creationOptionList() {
+    if (creation_options.empty()) {
+        return nullptr; // driver defaults
+    }
+    return creation_option_ptrs.data();
+}
+
+// Exact polygon masking (--mask-exact). The mask shapefile is rasterized
+// once per distinct pixel window into a 0/1 byte mask; scenes sharing a
+// grid reuse the cached mask, so in a normal run this rasterizes once.
+static std::string exact_mask_shp;
+static std::map<std::string, std::vector<unsigned char>> mask_cache;
+static std::mutex mask_cache_mutex;
+
+void setExactMask(const std::string& shpFile) {
+    std::lock_guard<std::mutex> lock(mask_cache_mutex);
+    if (shpFile != exact_mask_shp) {
+        // The cache is keyed by pixel window only; a different mask
+        // (e.g. the next job of a batch run) must not reuse old windows
+        mask_cache.clear();
+    }
+    exact_mask_shp = shpFile;
+}
+
+// Returns the cached window mask, or nullptr when masking is off or the
+// rasterization failed (failure is cached too, and only warned once)
+static const std::vector<unsigned char> *getWindowMask(const double gt[6],
+                                                       int width, int height) {
+    if (exact_mask_shp.empty()) {
+        return nullptr;
+    }
+
+    char key[160];
+    snprintf(key, sizeof(key), "%.6f_%.6f_%.6f_%.6f_%dx%d",
+             gt[0], gt[3], gt[1], gt[5], width, height);
+
+    std::lock_guard<std::mutex> lock(mask_cache_mutex);
+
+    auto it = mask_cache.find(key);
+    if (it != mask_cache.end()) {
+        return it->second.empty() ? nullptr : &it->second;
+    }
+
+    std::vector<unsigned char> mask;
+
+    GDALDataset *shp = (GDALDataset*)OGROpen(exact_mask_shp.c_str(), FALSE, nullptr);
+    GDALDriver *memDrv = (GDALDriver*)GDALGetDriverByName("MEM");
+    if (shp && memDrv && shp->GetLayer(0)) {
+        GDALDataset *mem = memDrv->Create("", width, height, 1, GDT_Byte, nullptr);
+        if (mem) {
+            double memGt[6] = { gt[0], gt[1], gt[2], gt[3], gt[4], gt[5] };
+            mem->SetGeoTransform(memGt);
+
+            int bandList = 1;
+            double burnValue = 1.0;
+            OGRLayerH layer = (OGRLayerH)shp->GetLayer(0);
+            if (GDALRasterizeLayers((GDALDatasetH)mem, 1, &bandList,
+                                    1, &layer, nullptr, nullptr,
+                                    &burnValue, nullptr,
+                                    nullptr, nullptr) == CE_None) {
+                mask.resize((size_t)width * height);
+                if (mem->GetRasterBand(1)->RasterIO(GF_Read, 0, 0, width, height,
+                                                    mask.data(), width, height,
+                                                    GDT_Byte, 0, 0, nullptr) != CE_None) {
+                    mask.clear();
+                }
+            }
+            GDALClose(mem);
+        }
+    }
+    if (shp) GDALClose(shp);
+
+    if (mask.empty()) {
+        std::cerr << "WARNING: Cannot rasterize mask polygon, writing "
+                  << "unmasked output.\n";
+    }
+
+    auto inserted = mask_cache.insert(std::make_pair(std::string(key),
+                                                     std::move(mask))).first;
+    return inserted->second.empty() ? nullptr : &inserted->second;
+}
+
+// Set pixels outside the polygon to the fill value. A select, not a
+// multiply/add blend: with a NaN nodata fill (common for float bands)
+// the blend's fill*0 term is NaN and would poison the pixels *inside*
+// the polygon. Compilers vectorize the select over the contiguous
+// buffer just as well.
+template <typename T>
+static void applyMaskT(T *p, const unsigned char *mask, size_t n, T fill) {
+    for (size_t i = 0; i < n; ++i) {
+        p[i] = mask[i] ? p[i] : fill;
+    }
+}
+
+static void applyMask(unsigned char *data, GDALDataType dtype,
+                      const unsigned char *mask, size_t npix, double fill) {
+    switch (dtype) {
+        case GDT_Byte:
+            applyMaskT((unsigned char*)data, mask, npix, (unsigned char)fill);
+            break;
+        case GDT_UInt16:
+            applyMaskT((unsigned short*)data, mask, npix, (unsigned short)fill);
+            break;
+        case GDT_Int16:
+            applyMaskT((short*)data, mask, npix, (short)fill);
+            break;
+        case GDT_UInt32:
+            applyMaskT((unsigned int*)data, mask, npix, (unsigned int)fill);
+            break;
+        case GDT_Int32:
+            applyMaskT((int*)data, mask, npix, (int)fill);
+            break;
+        case GDT_Float32:
+            applyMaskT((float*)data, mask, npix, (float)fill);
+            break;
+        case GDT_Float64:
+            applyMaskT((double*)data, mask, npix, fill);
+            break;
+        default:
+            break; // exotic types stay unmasked
+    }
+}
+
+namespace {
+// One filled chunk travelling from the reader stage to the writer stage
+struct ChunkSlot {
+    std::vector<unsigned char> data;
+    int row = 0;    // destination row of the chunk
+    int nrows = 0;  // rows in the chunk
+};
+} // namespace
+
+// Defined with the memory governor below; true when a buffer of this
+// size should not be held whole under the --mem-limit budget
+static bool exceedsBufferShare(size_t bytes);
+
+// Copy one band's window with a read-ahead pipeline: a reader thread
+// decodes block-aligned chunks into a bounded two-slot queue while the
+// caller writes (and the driver compresses) the previous chunk, so disk
+// reads and output compression overlap instead of alternating. Windows
+// that fit in a single chunk skip the thread and copy directly.
+static bool copyBandWindow(GDALRasterBand *sb, GDALRasterBand *db,
+                           int xOff, int yOff, int width, int height,
+                           GDALDataType dtype,
+                           const std::string &inFile,
+                           const std::string &outFile,
+                           const unsigned char *mask = nullptr,
+                           double maskFill = 0.0)
+{
+    int bx = 0, by = 0;
+    sb->GetBlockSize(&bx, &by);
+    if (by < 1) by = 1;
+
+    int dsize = GDALGetDataTypeSizeBytes(dtype);
+    size_t rowBytes = (size_t)width * dsize;
+
+    // Single-chunk window: plain copy through the reusable buffer
+    // (unless a --mem-limit budget says to stream it in block rows)
+    int firstChunk = by - (yOff % by);
+    if (firstChunk >= height && !exceedsBufferShare(rowBytes * height)) {
+        static thread_local std::vector<unsigned char> buffer;
+        if (buffer.size() < rowBytes * height) {
+            buffer.resize(rowBytes * height);
+        }
+        if (sb->RasterIO(GF_Read, xOff, yOff, width, height,
+                         buffer.data(), width, height, dtype,
+                         0, 0, nullptr) != CE_None) {
+            std::cerr << "ERROR: Read failed: " << inFile << "\n";
+            return false;
+        }
+        statsAddBytesRead(rowBytes * height);
+        if (mask) {
+            applyMask(buffer.data(), dtype, mask,
+                      (size_t)width * height, maskFill);
+        }
+        if (db->RasterIO(GF_Write, 0, 0, width, height,
+                         buffer.data(), width, height, dtype,
+                         0, 0, nullptr) != CE_None) {
+            std::cerr << "ERROR: Write failed: " << outFile << "\n";
+            return false;
+        }
+        statsAddBytesWritten(rowBytes * height);
+        return true;
+    }
+
+    std::deque<ChunkSlot> queue;
+    std::mutex mutex;
+    std::condition_variable cv_filled, cv_space;
+    bool read_error = false, write_error = false, read_done = false;
+
+    std::thread reader([&]() {
+        for (int row = 0; row < height; ) {
+            int srcRow = yOff + row;
+            int chunk = by - (srcRow % by);
+            if (chunk > height - row) chunk = height - row;
+
+            ChunkSlot slot;
+            slot.row = row;
+            slot.nrows = chunk;
+            slot.data.resize(rowBytes * chunk);
+
+            if (sb->RasterIO(GF_Read, xOff, srcRow, width, chunk,
+                             slot.data.data(), width, chunk, dtype,
+                             0, 0, nullptr) != CE_None) {
+                std::lock_guard<std::mutex> lock(mutex);
+                read_error = true;
+                cv_filled.notify_one();
+                return;
+            }
+            statsAddBytesRead(rowBytes * chunk);
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv_space.wait(lock, [&]() {
+                    return queue.size() < 2 || write_error;
+                });
+                if (write_error) return;
+                queue.push_back(std::move(slot));
+            }
+            cv_filled.notify_one();
+            row += chunk;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            read_done = true;
+        }
+        cv_filled.notify_one();
+    });
+
+    bool ok = true;
+    while (true) {
+        ChunkSlot slot;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv_filled.wait(lock, [&]() {
+                return !queue.empty() || read_done || read_error;
+            });
+            if (queue.empty()) {
+                if (read_error) {
+                    std::cerr << "ERROR: Read failed: " << inFile << "\n";
+                    ok = false;
+                }
+                break;
+            }
+            slot = std::move(queue.front());
+            queue.pop_front();
+        }
+        cv_space.notify_one();
+
+        if (mask) {
+            applyMask(slot.data.data(), dtype,
+                      mask + (size_t)slot.row * width,
+                      (size_t)width * slot.nrows, maskFill);
+        }
+        if (db->RasterIO(GF_Write, 0, slot.row, width, slot.nrows,
+                         slot.data.data(), width, slot.nrows, dtype,
+                         0, 0, nullptr) != CE_None) {
+            std::cerr << "ERROR: Write failed: " << outFile << "\n";
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                write_error = true;
+            }
+            cv_space.notify_one();
+            ok = false;
+            break;
+        }
+        statsAddBytesWritten(rowBytes * slot.nrows);
+    }
+
+    reader.join();
+    return ok;
+}
+
+// Zero-copy fast path for uncompressed, strip-organized, single-band
+// GeoTIFFs: mmap the file and memcpy the window rows straight from the
+// mapping into the output, bypassing GDAL's read path and block cache.
+// The strip offsets come from the GTiff driver's TIFF metadata domain.
+// Returns false when the layout doesn't qualify (or anything goes
+// wrong), in which case the caller falls back to the RasterIO path.
+static bool copyBandWindowMmapped(GDALDataset *src, GDALRasterBand *sb,
+                                  GDALRasterBand *db,
+                                  int xOff, int yOff, int width, int height,
+                                  GDALDataType dtype,
+                                  const std::string &inFile,
+                                  const std::string &outFile,
+                                  const unsigned char *mask,
+                                  double maskFill)
+{
+    if (inFile.compare(0, 4, "/vsi") == 0)
+        return false; // plain local files only
+
+    GDALDriver *drv = src->GetDriver();
+    if (!drv || strcmp(drv->GetDescription(), "GTiff") != 0)
+        return false;
+    if (src->GetRasterCount() != 1)
+        return false; // no pixel-interleave layouts to untangle
+
+    const char *comp = src->GetMetadataItem("COMPRESSION", "IMAGE_STRUCTURE");
+    if (comp && strcasecmp(comp, "NONE") != 0)
+        return false; // compressed, the decode path is needed
+
+    int rasterX = src->GetRasterXSize();
+    int bx = 0, by = 0;
+    sb->GetBlockSize(&bx, &by);
+    if (bx != rasterX || by < 1)
+        return false; // tiled, not strip-organized
+
+    int dsize = GDALGetDataTypeSizeBytes(dtype);
+    if (dsize <= 0)
+        return false;
+    size_t fullRowBytes = (size_t)rasterX * dsize;
+    size_t winRowBytes = (size_t)width * dsize;
+
+    // Strip file offsets for every strip the window touches
+    int firstStrip = yOff / by;
+    int lastStrip = (yOff + height - 1) / by;
+    std::vector<unsigned long long> stripOffsets;
+    stripOffsets.reserve(lastStrip - firstStrip + 1);
+    for (int s = firstStrip; s <= lastStrip; ++s) {
+        char item[64];
+        snprintf(item, sizeof(item), "BLOCK_OFFSET_0_%d", s);
+        const char *value = sb->GetMetadataItem(item, "TIFF");
+        if (!value)
+            return false; // sparse or unknown layout
+        stripOffsets.push_back(strtoull(value, nullptr, 10));
+    }
+
+    int fd = open(inFile.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    size_t fileSize = (size_t)st.st_size;
+
+    void *map = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file alive
+    if (map == MAP_FAILED)
+        return false;
+    const unsigned char *base = (const unsigned char*)map;
+
+    // Raw strip bytes skip the byte swap GDAL's read path would do, so
+    // only little-endian ("II") TIFFs qualify on the little-endian
+    // hosts we run on; big-endian ("MM") files take the safe path
+    if (fileSize < 4 || base[0] != 'I' || base[1] != 'I') {
+        munmap(map, fileSize);
+        return false;
+    }
+
+    // Assemble a few hundred rows at a time, then one RasterIO write
+    static thread_local std::vector<unsigned char> rowbuf;
+    const int maxChunk = 512;
+
+    bool ok = true;
+    for (int row = 0; row < height && ok; ) {
+        int chunk = maxChunk;
+        if (chunk > height - row) chunk = height - row;
+
+        if (rowbuf.size() < winRowBytes * chunk) {
+            rowbuf.resize(winRowBytes * chunk);
+        }
+
+        for (int r = 0; r < chunk; ++r) {
+            int srcRow = yOff + row + r;
+            size_t off = stripOffsets[srcRow / by - firstStrip]
+                       + (size_t)(srcRow % by) * fullRowBytes
+                       + (size_t)xOff * dsize;
+            if (off + winRowBytes > fileSize) {
+                ok = false; // truncated file, let the safe path handle it
+                break;
+            }
+            memcpy(rowbuf.data() + (size_t)r * winRowBytes, base + off,
+                   winRowBytes);
+        }
+        if (!ok)
+            break;
+
+        if (mask) {
+            applyMask(rowbuf.data(), dtype,
+                      mask + (size_t)row * width,
+                      (size_t)width * chunk, maskFill);
+        }
+        if (db->RasterIO(GF_Write, 0, row, width, chunk,
+                         rowbuf.data(), width, chunk, dtype,
+                         0, 0, nullptr) != CE_None) {
+            std::cerr << "ERROR: Write failed: " << outFile << "\n";
+            ok = false;
+            break;
+        }
+        statsAddBytesRead(winRowBytes * chunk);
+        statsAddBytesWritten(winRowBytes * chunk);
+        row += chunk;
+    }
+
+    munmap(map, fileSize);
+    return ok;
+}
+
+// Target-aligned pixels (--tap). Off by default: the raw bbox is used
+// as-is, as before.
+static bool tap_enabled = false;
+
+void setTargetAlignedPixels(bool enable) {
+    tap_enabled = enable;
+}
+
+// Snap the bbox outward to multiples of the pixel size (gdalwarp -tap).
+// Landsat grids place pixel edges on resolution multiples, so after
+// snapping every scene of a run resolves the same georeferenced corners
+// to the same integer window — no off-by-one-pixel drift between
+// scenes, and the 30 m snap nests exactly in the 15 m B8 grid.
+static void snapBBoxToGrid(double &minX, double &minY,
+                           double &maxX, double &maxY,
+                           double resX, double resY) {
+    if (!tap_enabled) return;
+    minX = std::floor(minX / resX) * resX;
+    maxX = std::ceil(maxX / resX) * resX;
+    minY = std::floor(minY / resY) * resY;
+    maxY = std::ceil(maxY / resY) * resY;
+}
+
+// ---- Memory budget governor (--mem-limit) ----
+// A global byte budget shared by all workers. Each clip reserves its
+// estimated footprint (window pixels x dtype) before touching the data
+// and blocks until it fits, so N-way parallelism cannot multiply
+// whole-window buffers past the cgroup limit. 0 = no budget (default).
+static long long mem_budget = 0;
+static long long mem_in_use = 0;
+static std::mutex mem_mutex;
+static std::condition_variable mem_cv;
+
+void setMemoryBudget(int memMB) {
+    if (memMB > 0) {
+        mem_budget = (long long)memMB * 1024 * 1024;
+    }
+}
+
+// True when a single buffer of this size would eat too much of the
+// budget; callers then stream block rows instead of buffering whole
+// windows
+static bool exceedsBufferShare(size_t bytes) {
+    return mem_budget > 0 && (long long)bytes > mem_budget / 8;
+}
+
+namespace {
+// Admission ticket, RAII. A window larger than the whole budget is
+// admitted once the engine is otherwise idle (it has to run eventually)
+// and everything else queues behind it.
+struct MemoryTicket {
+    long long bytes = 0;
+    explicit MemoryTicket(long long est) {
+        if (mem_budget <= 0 || est <= 0) return;
+        bytes = est;
+        std::unique_lock<std::mutex> lock(mem_mutex);
+        mem_cv.wait(lock, [this]() {
+            return mem_in_use == 0 || mem_in_use + bytes <= mem_budget;
+        });
+        mem_in_use += bytes;
+    }
+    ~MemoryTicket() {
+        if (bytes == 0) return;
+        {
+            std::lock_guard<std::mutex> lock(mem_mutex);
+            mem_in_use -= bytes;
+        }
+        mem_cv.notify_all();
+    }
+    MemoryTicket(const MemoryTicket&) = delete;
+    MemoryTicket& operator=(const MemoryTicket&) = delete;
+};
+} // namespace
+
+static int output_scale_percent = 100;
+
+void setOutputScale(int percent) {
+    if (percent < 1) percent = 1;
+    if (percent > 100) percent = 100;
+    output_scale_percent = percent;
+}
+
+// Reduced-resolution copy for --outsize: one RasterIO with a smaller
+// destination buffer and average resampling. GDAL serves the read from
+// the closest overview level when the source has one, so a 25% quicklook
+// touches ~1/16 of the base raster; without overviews the averaging
+// happens during the single windowed read instead of in a second pass.
+static bool copyBandWindowScaled(GDALRasterBand *sb, GDALRasterBand *db,
+                                 int xOff, int yOff, int width, int height,
+                                 int outW, int outH, GDALDataType dtype,
+                                 const std::string &inFile,
+                                 const std::string &outFile,
+                                 const unsigned char *mask = nullptr,
+                                 double maskFill = 0.0)
+{
+    size_t outBytes = (size_t)outW * outH * GDALGetDataTypeSizeBytes(dtype);
+    static thread_local std::vector<unsigned char> buffer;
+    if (buffer.size() < outBytes) {
+        buffer.resize(outBytes);
+    }
+
+    GDALRasterIOExtraArg extra;
+    INIT_RASTERIO_EXTRA_ARG(extra);
+    extra.eResampleAlg = GRIORA_Average;
+
+    if (sb->RasterIO(GF_Read, xOff, yOff, width, height,
+                     buffer.data(), outW, outH, dtype,
+                     0, 0, &extra) != CE_None) {
+        std::cerr << "ERROR: Read failed: " << inFile << "\n";
+        return false;
+    }
+    statsAddBytesRead(outBytes);
+    if (mask) {
+        applyMask(buffer.data(), dtype, mask, (size_t)outW * outH, maskFill);
+    }
+    if (db->RasterIO(GF_Write, 0, 0, outW, outH,
+                     buffer.data(), outW, outH, dtype,
+                     0, 0, nullptr) != CE_None) {
+        std::cerr << "ERROR: Write failed: " << outFile << "\n";
+        return false;
+    }
+    statsAddBytesWritten(outBytes);
+    return true;
+}
+
+// Reduced output dimensions for the current --outsize setting (identity
+// at 100%). Rounds up so a nonzero window never collapses to zero.
+static void scaledOutputSize(int width, int height, int &outW, int &outH) {
+    outW = width;
+    outH = height;
+    if (output_scale_percent < 100) {
+        outW = (width * output_scale_percent + 99) / 100;
+        outH = (height * output_scale_percent + 99) / 100;
+    }
+}
+
+bool clipRasterStack(const std::vector<std::string>& inFiles,
+                     const std::string& outFile,
+                     double minX, double minY,
+                     double maxX, double maxY,
+                     int epsgCode)
+{
+    if (inFiles.empty())
+        return false;
+
+    // Window and output geometry come from the first band file; every
+    // other input must share its grid (same resolution and alignment)
+    GDALDataset *first = (GDALDataset*)GDALOpen(inFiles[0].c_str(), GA_ReadOnly);
+    if (!first)
+        return false;
+
+    double gt[6];
+    if (first->GetGeoTransform(gt) != CE_None ||
+        gt[2] != 0.0 || gt[4] != 0.0 || gt[1] <= 0.0 || gt[5] >= 0.0) {
+        std::cerr << "ERROR: Unsupported geotransform for stacking: "
+                  << inFiles[0] << "\n";
+        GDALClose(first);
+        return false;
+    }
+
+    int rasterX = first->GetRasterXSize();
+    int rasterY = first->GetRasterYSize();
+
+    // --tap: align the bbox to the pixel grid before deriving the window
+    snapBBoxToGrid(minX, minY, maxX, maxY, gt[1], -gt[5]);
+
+    int xOff = (int)std::floor((minX - gt[0]) / gt[1]);
+    int yOff = (int)std::floor((maxY - gt[3]) / gt[5]);
+    int xEnd = (int)std::ceil((maxX - gt[0]) / gt[1]);
+    int yEnd = (int)std::ceil((minY - gt[3]) / gt[5]);
+
+    if (xOff < 0) xOff = 0;
+    if (yOff < 0) yOff = 0;
+    if (xEnd > rasterX) xEnd = rasterX;
+    if (yEnd > rasterY) yEnd = rasterY;
+
+    int width = xEnd - xOff;
+    int height = yEnd - yOff;
+    if (width <= 0 || height <= 0) {
+        std::cerr << "ERROR: Clip window does not intersect raster: "
+                  << inFiles[0] << "\n";
+        GDALClose(first);
+        return false;
+    }
+
+    GDALDataType dtype = first->GetRasterBand(1)->GetRasterDataType();
+    GDALClose(first);
+
+    // Admission under the --mem-limit budget: bands stream one at a
+    // time, so one window's worth is the honest footprint estimate
+    MemoryTicket ticket((long long)width * height *
+                        GDALGetDataTypeSizeBytes(dtype));
+
+    int outW, outH;
+    scaledOutputSize(width, height, outW, outH);
+
+    GDALDriver *drv = (GDALDriver*)GDALGetDriverByName("GTiff");
+    if (!drv)
+        return false;
+
+    GDALDataset *dst = drv->Create(outFile.c_str(), outW, outH,
+                                   (int)inFiles.size(), dtype,
+                                   creationOptionList());
+    if (!dst) {
+        std::cerr << "ERROR: Cannot create output: " << outFile << "\n";
+        return false;
+    }
+
+    double outGt[6] = {
+        gt[0] + xOff * gt[1], gt[1] * width / outW, 0.0,
+        gt[3] + yOff * gt[5], 0.0, gt[5] * height / outH
+    };
+    dst->SetGeoTransform(outGt);
+
+    std::string wkt = getWKTFromEPSG(epsgCode);
+    if (!wkt.empty()) {
+        dst->SetProjection(wkt.c_str());
+    }
+
+    const std::vector<unsigned char> *window_mask =
+        getWindowMask(outGt, outW, outH);
+
+    bool ok = true;
+
+    // One pass: each source band file is opened, streamed into its slot
+    // of the multi-band output, and released, reusing the same window
+    // for all of them
+    for (size_t i = 0; i < inFiles.size() && ok; ++i) {
+        GDALDataset *src = (GDALDataset*)GDALOpen(inFiles[i].c_str(), GA_ReadOnly);
+        if (!src) {
+            std::cerr << "ERROR: Cannot open: " << inFiles[i] << "\n";
+            ok = false;
+            break;
+        }
+
+        double srcGt[6];
+        if (src->GetGeoTransform(srcGt) != CE_None ||
+            srcGt[0] != gt[0] || srcGt[1] != gt[1] ||
+            srcGt[3] != gt[3] || srcGt[5] != gt[5] ||
+            src->GetRasterXSize() != rasterX ||
+            src->GetRasterYSize() != rasterY) {
+            std::cerr << "ERROR: Grid mismatch, cannot stack: "
+                      << inFiles[i] << "\n";
+            GDALClose(src);
+            ok = false;
+            break;
+        }
+
+        GDALRasterBand *sb = src->GetRasterBand(1);
+        GDALRasterBand *db = dst->GetRasterBand((int)i + 1);
+
+        int hasNodata = 0;
+        double nodata = sb->GetNoDataValue(&hasNodata);
+        if (hasNodata) {
+            db->SetNoDataValue(nodata);
+        }
+
+        const unsigned char *maskData =
+            window_mask ? window_mask->data() : nullptr;
+        double fill = hasNodata ? nodata : 0.0;
+
+        if (outW != width || outH != height) {
+            // Decimated output: single averaged read, no fast paths
+            if (!copyBandWindowScaled(sb, db, xOff, yOff, width, height,
+                                      outW, outH, dtype, inFiles[i], outFile,
+                                      maskData, fill)) {
+                ok = false;
+            }
+        // Try the mmap fast path first; it declines layouts it cannot do
+        } else if (!copyBandWindowMmapped(src, sb, db, xOff, yOff, width, height,
+                                   dtype, inFiles[i], outFile,
+                                   maskData, fill) &&
+            !copyBandWindow(sb, db, xOff, yOff, width, height, dtype,
+                            inFiles[i], outFile, maskData, fill)) {
+            ok = false;
+        }
+
+        GDALClose(src);
+    }
+
+    GDALClose(dst);
+    return ok;
+}
+
+void configureRemoteIO() {
+    // Curl-backed /vsi reads: skip the directory probe when opening each
+    // file, let the GTiff driver merge adjacent tile reads into single
+    // ranged requests, and keep a cache of fetched ranges, so a windowed
+    // clip transfers roughly the tile ranges under the window and not
+    // the whole object
+    CPLSetConfigOption("GDAL_DISABLE_READDIR_ON_OPEN", "EMPTY_DIR");
+    CPLSetConfigOption("GDAL_HTTP_MULTIRANGE", "YES");
+    CPLSetConfigOption("GDAL_HTTP_MERGE_CONSECUTIVE_RANGES", "YES");
+    CPLSetConfigOption("GDAL_HTTP_MAX_RETRY", "3");
+    CPLSetConfigOption("CPL_VSIL_CURL_CACHE_SIZE", "67108864");  // 64 MB
+}
+
+void setClipCacheBudget(int cacheMB) {
+    if (cacheMB > 0) {
+        GDALSetCacheMax64((GIntBig)cacheMB * 1024 * 1024);
+    }
+}
+
+// LRU pool of idle, read-only source dataset handles keyed by file path.
+// GDAL handles are not thread-safe, so a handle is either idle in the
+// pool or checked out by exactly one worker; releasing a handle for a
+// path that already has an idle one just closes the extra.
+namespace {
+struct IdleDataset {
+    GDALDataset *ds;
+    unsigned long last_used;
+};
+
+class DatasetPool {
+public:
+    GDALDataset *acquire(const std::string &path) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = idle.find(path);
+            if (it != idle.end()) {
+                GDALDataset *ds = it->second.ds;
+                idle.erase(it);
+                return ds;
+            }
+        }
+        // Open outside the lock so slow opens don't serialize the workers
+        return (GDALDataset*)GDALOpen(path.c_str(), GA_ReadOnly);
+    }
+
+    void release(const std::string &path, GDALDataset *ds) {
+        GDALDataset *to_close = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (capacity > 0 && idle.find(path) == idle.end()) {
+                IdleDataset entry;
+                entry.ds = ds;
+                entry.last_used = ++counter;
+                idle[path] = entry;
+                if (idle.size() > capacity) {
+                    // Evict the least recently returned handle
+                    auto oldest = idle.begin();
+                    for (auto it = idle.begin(); it != idle.end(); ++it) {
+                        if (it->second.last_used < oldest->second.last_used) {
+                            oldest = it;
+                        }
+                    }
+                    to_close = oldest->second.ds;
+                    idle.erase(oldest);
+                }
+            } else {
+                to_close = ds; // pooling off, or a duplicate idle handle
+            }
+        }
+        if (to_close) GDALClose(to_close);
+    }
+
+    void setCapacity(size_t maxOpen) {
+        std::vector<GDALDataset*> to_close;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            capacity = maxOpen;
+            while (idle.size() > capacity) {
+                auto oldest = idle.begin();
+                for (auto it = idle.begin(); it != idle.end(); ++it) {
+                    if (it->second.last_used < oldest->second.last_used) {
+                        oldest = it;
+                    }
+                }
+                to_close.push_back(oldest->second.ds);
+                idle.erase(oldest);
+            }
+        }
+        for (GDALDataset *ds : to_close) GDALClose(ds);
+    }
+
+private:
+    std::map<std::string, IdleDataset> idle;
+    std::mutex mutex;
+    unsigned long counter = 0;
+    size_t capacity = 8;
+};
+
+DatasetPool dataset_pool;
+} // namespace
+
+void setDatasetPoolCapacity(size_t maxOpen) {
+    dataset_pool.setCapacity(maxOpen);
+}
+
+bool clipRasterWindowed(const std::string& inFile,
+                        const std::string& outFile,
+                        double minX, double minY,
+                        double maxX, double maxY,
+                        int epsgCode)
+{
+    GDALDataset *src;
+    {
+        ScopedTimer t("open");
+        src = dataset_pool.acquire(inFile);
+    }
+    if (!src)
+        return false;
+
+    // ---- Pixel window from the geotransform, computed once ----
+    double gt[6];
+    if (src->GetGeoTransform(gt) != CE_None ||
+        gt[2] != 0.0 || gt[4] != 0.0 || gt[1] <= 0.0 || gt[5] >= 0.0) {
+        // Rotated or exotic geotransform: not our fast case, let the
+        // generic GDALTranslate path deal with it
+        dataset_pool.release(inFile, src);
+        return clipRasterByBBox(inFile, outFile, minX, minY, maxX, maxY, epsgCode);
+    }
+
+    int rasterX = src->GetRasterXSize();
+    int rasterY = src->GetRasterYSize();
+
+    // --tap: align the bbox to the pixel grid before deriving the window
+    snapBBoxToGrid(minX, minY, maxX, maxY, gt[1], -gt[5]);
+
+    // North-up raster: row 0 is maxY, gt[5] is negative
+    int xOff = (int)std::floor((minX - gt[0]) / gt[1]);
+    int yOff = (int)std::floor((maxY - gt[3]) / gt[5]);
+    int xEnd = (int)std::ceil((maxX - gt[0]) / gt[1]);
+    int yEnd = (int)std::ceil((minY - gt[3]) / gt[5]);
+
+    // Clamp to the raster, like -projwin does for partial overlaps
+    if (xOff < 0) xOff = 0;
+    if (yOff < 0) yOff = 0;
+    if (xEnd > rasterX) xEnd = rasterX;
+    if (yEnd > rasterY) yEnd = rasterY;
+
+    int width = xEnd - xOff;
+    int height = yEnd - yOff;
+    if (width <= 0 || height <= 0) {
+        std::cerr << "ERROR: Clip window does not intersect raster: "
+                  << inFile << "\n";
+        dataset_pool.release(inFile, src);
+        return false;
+    }
+
+    int nBands = src->GetRasterCount();
+    GDALDataType dtype = src->GetRasterBand(1)->GetRasterDataType();
+
+    // Admission under the --mem-limit budget: reserve the window's
+    // estimated footprint before any buffering starts
+    MemoryTicket ticket((long long)width * height *
+                        GDALGetDataTypeSizeBytes(dtype));
+
+    if (isVSIPath(inFile)) {
+        // Prefetch hint for remote inputs: drivers that support it issue
+        // concurrent ranged reads covering exactly the clip window
+        src->AdviseRead(xOff, yOff, width, height, width, height, dtype,
+                        0, nullptr, nullptr);
+    }
+
+    // --outsize: reduced output grid, pixel size grows accordingly
+    int outW, outH;
+    scaledOutputSize(width, height, outW, outH);
+
+    // ---- Create the output directly, no option parsing ----
+    GDALDriver *drv = (GDALDriver*)GDALGetDriverByName("GTiff");
+    if (!drv) {
+        dataset_pool.release(inFile, src);
+        return false;
+    }
+    GDALDataset *dst = drv->Create(outFile.c_str(), outW, outH,
+                                   nBands, dtype, creationOptionList());
+    if (!dst) {
+        std::cerr << "ERROR: Cannot create output: " << outFile << "\n";
+        dataset_pool.release(inFile, src);
+        return false;
+    }
+
+    double outGt[6] = {
+        gt[0] + xOff * gt[1], gt[1] * width / outW, 0.0,
+        gt[3] + yOff * gt[5], 0.0, gt[5] * height / outH
+    };
+    dst->SetGeoTransform(outGt);
+
+    {
+        ScopedTimer t("crs");
+        std::string wkt = getWKTFromEPSG(epsgCode);
+        if (!wkt.empty()) {
+            dst->SetProjection(wkt.c_str());
+        }
+    }
+
+    const std::vector<unsigned char> *window_mask =
+        getWindowMask(outGt, outW, outH);
+
+    bool ok = true;
+
+    {
+        ScopedTimer t("clip");
+        for (int b = 1; b <= nBands && ok; ++b) {
+            GDALRasterBand *sb = src->GetRasterBand(b);
+            GDALRasterBand *db = dst->GetRasterBand(b);
+
+            int hasNodata = 0;
+            double nodata = sb->GetNoDataValue(&hasNodata);
+            if (hasNodata) {
+                db->SetNoDataValue(nodata);
+            }
+
+            // Block-aligned chunks, read ahead by a pipeline stage so every
+            // strip/tile row is decoded exactly once and reads overlap writes
+            const unsigned char *maskData =
+                window_mask ? window_mask->data() : nullptr;
+            double fill = hasNodata ? nodata : 0.0;
+
+            if (outW != width || outH != height) {
+                // Decimated output: single averaged read, no fast paths
+                if (!copyBandWindowScaled(sb, db, xOff, yOff, width, height,
+                                          outW, outH, dtype, inFile, outFile,
+                                          maskData, fill)) {
+                    ok = false;
+                }
+            // Try the mmap fast path first; it declines layouts it cannot do
+            } else if (!copyBandWindowMmapped(src, sb, db, xOff, yOff, width, height,
+                                       dtype, inFile, outFile,
+                                       maskData, fill) &&
+                !copyBandWindow(sb, db, xOff, yOff, width, height, dtype,
+                                inFile, outFile, maskData, fill)) {
+                ok = false;
+            }
+        }
+    }
+
+    {
+        ScopedTimer t("close");
+        GDALClose(dst);
+        dataset_pool.release(inFile, src);
+    }
+
+    return ok;
+}
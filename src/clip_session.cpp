@@ -0,0 +1,73 @@
+#include <iostream>
+#include <mutex>
+
+#include "clip_session.hpp"
+#include "clip_engine.hpp"
+#include "utils.hpp"
+
+// GDAL/OGR driver registration must happen exactly once per process, no
+// matter how many sessions the caller creates
+static std::once_flag drivers_registered;
+
+ClipSession::ClipSession() : epsg_code(-1) {
+    std::call_once(drivers_registered, []() {
+        GDALAllRegister();
+        OGRRegisterAll();
+    });
+}
+
+bool ClipSession::loadMask(const std::string &shpFile, double margin) {
+    double xmin, xmax, ymin, ymax;
+    if (!getShapefileExtent(shpFile, xmin, xmax, ymin, ymax)) {
+        return false;
+    }
+
+    bbox.minX = xmin - margin;
+    bbox.minY = ymin - margin;
+    bbox.maxX = xmax + margin;
+    bbox.maxY = ymax + margin;
+
+    return true;
+}
+
+void ClipSession::setBBox(const BBox &box) {
+    bbox = box;
+}
+
+BBox ClipSession::getBBox() const {
+    return bbox;
+}
+
+void ClipSession::setEPSG(int epsgCode) {
+    epsg_code = epsgCode;
+}
+
+int ClipSession::getEPSG() const {
+    return epsg_code;
+}
+
+bool ClipSession::clip(const std::string &inFile, const std::string &outFile) const {
+    return clip(inFile, outFile, epsg_code);
+}
+
+bool ClipSession::clip(const std::string &inFile, const std::string &outFile,
+                       int epsgCode) const {
+    if (epsgCode == -1) {
+        std::cerr << "ERROR: ClipSession has no EPSG code set.\n";
+        return false;
+    }
+    return clipRasterWindowed(inFile, outFile,
+                              bbox.minX, bbox.minY, bbox.maxX, bbox.maxY,
+                              epsgCode);
+}
+
+bool ClipSession::clipStack(const std::vector<std::string> &inFiles,
+                            const std::string &outFile, int epsgCode) const {
+    if (epsgCode == -1) {
+        std::cerr << "ERROR: ClipSession has no EPSG code set.\n";
+        return false;
+    }
+    return clipRasterStack(inFiles, outFile,
+                           bbox.minX, bbox.minY, bbox.maxX, bbox.maxY,
+                           epsgCode);
+}
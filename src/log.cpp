@@ -0,0 +1,24 @@
+#include <cstdio>
+
+#include "log.hpp"
+
+static LogLevel log_level = LOG_NORMAL;
+
+void logSetLevel(LogLevel level) {
+    log_level = level;
+
+    // Full buffering with a generous buffer: without this, stdout is
+    // line-buffered (or worse, unbuffered under some job schedulers) and
+    // per-file logging turns into one write syscall per line
+    static char log_buffer[1 << 16];
+    setvbuf(stdout, log_buffer, _IOFBF, sizeof(log_buffer));
+    std::ios::sync_with_stdio(true); // cout shares the stdout buffer
+}
+
+LogLevel logGetLevel() {
+    return log_level;
+}
+
+void logFlush() {
+    std::cout.flush();
+}
@@ -7,31 +7,495 @@
  *****************************************************************************/
 
 #include <getopt.h>
+#include <sys/stat.h>
 #include <string>
 #include <vector>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <cstdlib>
 
 #include "utils.hpp"
-
-int main(int argc, char* argv[]) {
-
+#include "clip_engine.hpp"
+#include "clip_session.hpp"
+#include "log.hpp"
+#include "stats.hpp"
+#include "worker_pool.hpp"
+
+// Long-only options (no short letter left for them)
+enum {
+    OPT_CO = 1000,
+    OPT_PROFILE,
+    OPT_MASK_EXACT,
+    OPT_STATS,
+    OPT_OUTSIZE,
+    OPT_MANIFEST,
+    OPT_TAP,
+    OPT_MEM_LIMIT
+};
+
+// One clip task: everything a worker needs, resolved up front so workers
+// never touch shared state (each opens its own GDAL handles).
+struct ClipTask {
+    std::string fname;    // original file (or scene) name, for error reporting
+    std::vector<std::string> inFiles;  // one per output band; one entry unless stacking
+    std::string outFile;
+    int epsgCode;
+};
+
+// One clip job: an (input dir, output dir, mask, datasets) unit of work.
+// A normal run is one job built from argv; --manifest runs many in one
+// process, sharing driver registration, caches and the session.
+struct ClipJob {
     std::string input_dir;
     std::string output_dir;
     std::string source_crs;
-    std::string mask_subset;
+    std::string mask;
     std::string datasets;
     std::string pattern;
     std::string label;
-    bool debug = false;
+};
+
+// Flags that apply to every job of the run
+struct RunConfig {
+    bool resume = false;
+    bool recursive = false;
+    bool stack = false;
+    bool mask_exact = false;
+    int jobs = 1;
+};
+
+// Rank/size contract for multi-node runs: CLIP_RANK/CLIP_SIZE if set,
+// otherwise the scheduler's SLURM_PROCID/SLURM_NTASKS. Defaults to a
+// single rank owning everything.
+static void getShardInfo(int &rank, int &size) {
+    rank = 0;
+    size = 1;
+    const char *rank_env = getenv("CLIP_RANK");
+    const char *size_env = getenv("CLIP_SIZE");
+    if (!rank_env || !size_env) {
+        rank_env = getenv("SLURM_PROCID");
+        size_env = getenv("SLURM_NTASKS");
+    }
+    if (rank_env && size_env) {
+        rank = std::atoi(rank_env);
+        size = std::atoi(size_env);
+    }
+    if (size < 1) size = 1;
+    if (rank < 0 || rank >= size) rank = 0;
+}
+
+static int runClipJob(const ClipJob& job, const RunConfig& cfg,
+                      ClipSession& session) {
+
+    if (job.input_dir.empty() || job.output_dir.empty() ||
+        job.source_crs.empty() || job.mask.empty() || job.datasets.empty()) {
+        std::cerr << "ERROR: A job needs input dir, output dir, source CRS, "
+                  << "mask and datasets.\n";
+        return EXIT_FAILURE;
+    }
+
+    // source_crs may be replaced per scene from the MTL metadata
+    std::string source_crs = job.source_crs;
+
+    // Show initial parameters
+
+    LOG(LOG_NORMAL) << "Input directory: " << job.input_dir << "\n";
+    // /vsi inputs (object storage) are validated by the listing itself
+    if (!isVSIPath(job.input_dir) && !directory_exists(job.input_dir)) {
+        std::cerr << "ERROR: Input directory not found: " << job.input_dir << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    LOG(LOG_NORMAL) << "Output directory: " << job.output_dir << "\n";
+    if (!directory_exists(job.output_dir)) {
+        std::cerr << "ERROR: Output directory not found: " << job.output_dir << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    LOG(LOG_NORMAL) << "Source CRS: " << source_crs << "\n";
+    LOG(LOG_NORMAL) << "Mask: " << job.mask << "\n";
+    LOG(LOG_NORMAL) << "Label: " << job.label << "\n";
+    LOG(LOG_NORMAL) << "Pattern: " << job.pattern << "\n";
+
+    std::vector<std::string> list_datasets = split_by_commas(job.datasets);
+    if (list_datasets.empty()) {
+        std::cerr << "No datasets provided! Exiting.\n";
+        return EXIT_FAILURE;
+    }
+    LOG(LOG_NORMAL) << "Datasets: ";
+    for (const std::string &ds : list_datasets) {
+        LOG(LOG_NORMAL) << ds << " ";
+    }
+    LOG(LOG_NORMAL) << "\n";
 
-    std::vector<std::string> list_datasets;
-    std::vector<u_int8_t> list_tiers;
+    // Object-store inputs: tune the curl VSI layer for ranged reads
+    if (isVSIPath(job.input_dir)) {
+        configureRemoteIO();
+    }
+
+    // Exact polygon masking during the clip (the bbox clip alone keeps
+    // the inflated rectangle around the polygon)
+    if (cfg.mask_exact) {
+        setExactMask(job.mask);
+    }
+
+    // Get extent from polygon, inflated by 31 m (one 30 m pixel + 1)
+    if (!session.loadMask(job.mask, 31)) {
+        std::cerr << "ERROR: Failed to read shapefile extent\n";
+        return EXIT_FAILURE;
+    }
+    BBox extent = session.getBBox();
+    LOG(LOG_NORMAL) << "Extent:\n";
+    LOG(LOG_NORMAL) << "minX=" << std::fixed << std::setprecision(15) << extent.minX
+                    << ", minY=" << extent.minY << ", maxX=" << extent.maxX
+                    << ", maxY=" << extent.maxY << "\n";
+
+    // Manifest with the bbox+EPSG of the last run: if the mask extent (or
+    // the CRS) changed, existing outputs are stale and --resume must not
+    // skip them
+    std::string manifest_file = job.output_dir;
+    if (job.output_dir.back() != '/') manifest_file += "/";
+    manifest_file += ".clip_manifest";
+
+    int run_epsg = parseEPSG(source_crs);
+    bool resume_skip_ok = cfg.resume;
+    if (cfg.resume) {
+        double mMinX, mMinY, mMaxX, mMaxY;
+        int mEpsg;
+        if (readClipManifest(manifest_file, mMinX, mMinY, mMaxX, mMaxY, mEpsg)) {
+            if (mMinX != extent.minX || mMinY != extent.minY ||
+                mMaxX != extent.maxX || mMaxY != extent.maxY ||
+                mEpsg != run_epsg) {
+                LOG(LOG_NORMAL) << "Mask extent or CRS changed since last run, "
+                                << "re-clipping everything.\n";
+                resume_skip_ok = false;
+            }
+        }
+    }
+    // The manifest is rewritten only after the dispatch loop finishes
+    // with zero failures (below): updating it up front would make a
+    // crashed re-clip run look complete to the next --resume, which
+    // would then skip outputs produced under the old bbox forever
+
+    // Single indexing pass over the directory: extension and pattern are
+    // filtered during the walk, files are grouped by band suffix. With
+    // --recursive the tree is walked by --jobs threads, one per subdir.
+    FileIndex file_index;
+    {
+        ScopedTimer t("scan");
+        file_index = buildFileIndex(job.input_dir, job.pattern,
+                                    cfg.recursive, cfg.jobs);
+    }
+
+    // Build the full (file, band) work list up front, then dispatch it to
+    // the workers. Filtering and metadata parsing stay serial (cheap);
+    // only the clip itself runs in parallel.
+    std::vector<ClipTask> clip_tasks;
+
+    if (cfg.stack) {
+        // --stack: one multi-band output per scene instead of one file per
+        // (scene, band). Group the indexed files by scene ID, keeping the
+        // requested band order as the output band order.
+        LOG(LOG_NORMAL) << "\n======Stacking scenes======\n";
+
+        std::map<std::string, std::vector<std::string>> scene_files;
+        for (size_t bi = 0; bi < list_datasets.size(); ++bi) {
+            for (const std::string &fname : filesForBand(file_index, list_datasets[bi])) {
+                std::string scene(splitPathView(fname).basename.substr(0, 40));
+                std::vector<std::string> &slots = scene_files[scene];
+                slots.resize(list_datasets.size());
+                if (slots[bi].empty()) {
+                    slots[bi] = fname;
+                }
+            }
+        }
+
+        for (const auto &entry : scene_files) {
+            bool complete = true;
+            for (const std::string &slot : entry.second) {
+                if (slot.empty()) complete = false;
+            }
+            if (!complete) {
+                LOG(LOG_NORMAL) << "WARNING: Scene " << entry.first
+                                << " is missing requested bands, skipping.\n";
+                continue;
+            }
+
+            // Resolve the CRS once per scene from its metadata
+            std::string projection;
+            int utm_zone = 0;
+            if (getSceneProjectionInfo(job.input_dir, entry.second[0], projection, utm_zone)) {
+                std::string temp_crs = getEPSGFromUTMZone(utm_zone);
+                if (!temp_crs.empty() && (source_crs != temp_crs)) {
+                    source_crs = temp_crs;
+                }
+            }
+            int epsgCode = parseEPSG(source_crs);
+            if (epsgCode == -1) {
+                std::cerr << "ERROR: Failed to get EPSG code.\n";
+                return EXIT_FAILURE;
+            }
+
+            ClipTask task;
+            task.fname = entry.first;
+            for (const std::string &slot : entry.second) {
+                std::string inFile = job.input_dir;
+                if (job.input_dir.back() != '/') inFile += "/";
+                inFile += slot;
+                task.inFiles.push_back(inFile);
+            }
+            task.outFile = job.output_dir;
+            if (job.output_dir.back() != '/') task.outFile += "/";
+            task.outFile += entry.first + job.label + ".tif";
+            task.epsgCode = epsgCode;
+
+            LOG(LOG_NORMAL) << "Scene=" << entry.first << " -> " << task.outFile
+                            << " (" << task.inFiles.size() << " bands)\n";
+            clip_tasks.push_back(std::move(task));
+        }
+    } else {
+
+    // Hoisted out of the per-file loop: the prefixes are built once and
+    // inFile/outFile reuse their capacity across iterations, so the
+    // steady-state filter-and-dispatch loop does no per-file heap
+    // allocation beyond the strings stored into the task list itself
+    std::string input_prefix = job.input_dir;
+    if (input_prefix.back() != '/') input_prefix += "/";
+    std::string output_prefix = job.output_dir;
+    if (output_prefix.back() != '/') output_prefix += "/";
+    std::string inFile, outFile;
+    inFile.reserve(input_prefix.size() + 128);
+    outFile.reserve(output_prefix.size() + 128);
+
+    for (const std::string &band : list_datasets) {
+
+        LOG(LOG_NORMAL) << "\n======Processing " << band << "======\n";
+
+        for (const std::string &fname : filesForBand(file_index, band)) {
+
+            LOG(LOG_NORMAL) << "File=" << fname << ", ";
+
+            PathPartsView file_parts = splitPathView(fname);
+            LOG(LOG_VERBOSE) << "Input filename: \n"
+                             << "  Directory: " << file_parts.directory << "\n"
+                             << "  Basename:  " << file_parts.basename << "\n"
+                             << "  Stem:      " << file_parts.stem << "\n"
+                             << "  Extension: " << file_parts.extension << "\n";
+
+            std::string projection;
+            int utm_zone = 0;
+
+            // Parse metadata file (cached per scene, the MTL is shared by
+            // all bands of a scene)
+            bool have_metadata;
+            {
+                ScopedTimer t("metadata");
+                have_metadata = getSceneProjectionInfo(job.input_dir, fname,
+                                                       projection, utm_zone);
+            }
+            if (have_metadata) {
+                // Create CRS from the metadata file
+                LOG(LOG_NORMAL) << "Metadata: Proj=" << projection << ", Zone=" << utm_zone << "\n";
+                std::string temp_crs = getEPSGFromUTMZone(utm_zone);  // All Landsat are Northern hemisphere
+                LOG(LOG_VERBOSE) << "  Source CRS=" << source_crs << ", temp CRS=" << temp_crs << "\n";
+                if (!temp_crs.empty() && (source_crs != temp_crs)) {
+                    // If valid temp_crs and different than the source CRS, replace the source CRS
+                    LOG(LOG_NORMAL) << "***Updating CRS " << source_crs << " with " << temp_crs << "\n";
+                    source_crs = temp_crs;
+                }
+            } else {
+                // Continue using default CRS
+                LOG(LOG_NORMAL) << "WARNING: Metadata not found or extraction faileded! Using source CRS=" << source_crs << "\n";
+            }
+
+            int epsgCode = parseEPSG(source_crs);
+            if (epsgCode == -1) {
+                std::cerr << "ERROR: Failed to get EPSG code.\n";
+                return EXIT_FAILURE;
+            }
+
+            // Create the input file name for clipping (keep any
+            // subdirectory prefix from a recursive scan)
+            inFile.assign(input_prefix);
+            inFile += fname;
+            outFile.assign(output_prefix);
+            outFile.append(file_parts.stem);
+            outFile += job.label;
+            outFile.append(file_parts.extension);
+
+            LOG(LOG_NORMAL) << "inFile: " << inFile << "\n";
+            LOG(LOG_NORMAL) << "outFile: " << outFile << "\n";
+            LOG(LOG_NORMAL) << "epsgCode: " << epsgCode << "\n";
+
+            ClipTask task;
+            task.fname = fname;
+            task.inFiles.push_back(inFile);
+            task.outFile = outFile;
+            task.epsgCode = epsgCode;
+            clip_tasks.push_back(std::move(task));
+        }
+    }
+
+    }
+
+    // Multi-node sharding: the task list is built in the same
+    // deterministic order on every rank (sorted file index, fixed band
+    // order), so a simple round-robin by index partitions the archive
+    // with no coordination. The shard is taken from the FULL task list
+    // — the --resume skip runs afterwards, inside each rank's shard.
+    // Filtering first would let a late-starting rank see outputs other
+    // ranks wrote mid-run, shift its indices, and end up writing files
+    // another rank owns.
+    int shard_rank, shard_size;
+    getShardInfo(shard_rank, shard_size);
+    if (shard_size > 1) {
+        size_t total = clip_tasks.size();
+        std::vector<ClipTask> shard;
+        shard.reserve(total / shard_size + 1);
+        for (size_t i = shard_rank; i < total; i += shard_size) {
+            shard.push_back(std::move(clip_tasks[i]));
+        }
+        clip_tasks = std::move(shard);
+        LOG(LOG_NORMAL) << "\nRank " << shard_rank << " of " << shard_size
+                        << ": " << clip_tasks.size() << " of " << total
+                        << " task(s) in this shard.\n";
+    }
+
+    // In resume mode, skip outputs that are newer than every one of
+    // their inputs (a stacked output must be newer than each band)
+    if (resume_skip_ok) {
+        std::vector<ClipTask> pending;
+        pending.reserve(clip_tasks.size());
+        for (ClipTask &task : clip_tasks) {
+            bool up_to_date = true;
+            for (const std::string &in : task.inFiles) {
+                if (!outputUpToDate(in, task.outFile)) {
+                    up_to_date = false;
+                    break;
+                }
+            }
+            if (up_to_date) {
+                LOG(LOG_NORMAL) << "Up to date, skipping: " << task.outFile << "\n";
+            } else {
+                pending.push_back(std::move(task));
+            }
+        }
+        clip_tasks = std::move(pending);
+    }
+
+    LOG(LOG_NORMAL) << "\nDispatching " << clip_tasks.size() << " clip task(s) on "
+                    << cfg.jobs << " worker(s)...\n";
+
+    std::atomic<size_t> failed_clips(0);
+    std::mutex print_mutex;
+
+    if (cfg.jobs == 1) {
+        // Serial mode, same behavior as before: stop on first failure
+        for (const ClipTask &task : clip_tasks) {
+            bool ok = (task.inFiles.size() == 1)
+                ? session.clip(task.inFiles[0], task.outFile, task.epsgCode)
+                : session.clipStack(task.inFiles, task.outFile, task.epsgCode);
+            if (!ok) {
+                std::cerr << "ERROR: Failed to clip: " << task.fname << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+    } else {
+        WorkerPool pool(cfg.jobs);
+        for (const ClipTask &task : clip_tasks) {
+            // Input bytes as the cost hint, so the pool balances by data
+            // volume (B8 is 4x the pixels of a 30m band) instead of count
+            size_t cost = 0;
+            for (const std::string &in : task.inFiles) {
+                long long size = getFileSize(in); // /vsi-aware
+                if (size > 0) {
+                    cost += (size_t)size;
+                }
+            }
+            // Capture the task by value: each worker gets private strings
+            // and opens its own GDAL dataset handles
+            pool.addTask([task, &session, &failed_clips, &print_mutex]() {
+                bool ok = (task.inFiles.size() == 1)
+                    ? session.clip(task.inFiles[0], task.outFile, task.epsgCode)
+                    : session.clipStack(task.inFiles, task.outFile, task.epsgCode);
+                if (!ok) {
+                    std::lock_guard<std::mutex> lock(print_mutex);
+                    std::cerr << "ERROR: Failed to clip: " << task.fname << "\n";
+                    failed_clips++;
+                }
+            }, cost);
+        }
+        pool.run();
+
+        if (failed_clips > 0) {
+            std::cerr << "ERROR: " << failed_clips << " of " << clip_tasks.size()
+                      << " clip task(s) failed." << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Every task succeeded: record this run's bbox+EPSG. On any failure
+    // path above the old manifest stays in place, so an interrupted
+    // re-clip is re-detected and resumed (the clip is idempotent).
+    if (!writeClipManifest(manifest_file, extent.minX, extent.minY,
+                           extent.maxX, extent.maxY, run_epsg)) {
+        std::cerr << "WARNING: Cannot write manifest: " << manifest_file << "\n";
+    }
+
+    logFlush();
+    // Per-job summary, printed even in quiet mode
+    std::cout << clip_tasks.size() << " clip task(s) completed.\n";
+    return EXIT_SUCCESS;
+}
+
+// One job per line: idir;odir;mask;datasets[;pattern[;label]]. Blank
+// lines and lines starting with '#' are skipped; empty fields fall back
+// to the corresponding command-line argument.
+static bool parseJobLine(const std::string& line, const ClipJob& defaults,
+                         ClipJob& job) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (true) {
+        size_t sep = line.find(';', start);
+        fields.push_back(line.substr(start, sep - start));
+        if (sep == std::string::npos) break;
+        start = sep + 1;
+    }
+    if (fields.size() < 4) {
+        return false;
+    }
+
+    job = defaults;
+    if (!fields[0].empty()) job.input_dir = fields[0];
+    if (!fields[1].empty()) job.output_dir = fields[1];
+    if (!fields[2].empty()) job.mask = fields[2];
+    if (!fields[3].empty()) job.datasets = fields[3];
+    if (fields.size() > 4) job.pattern = fields[4];
+    if (fields.size() > 5) job.label = fields[5];
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+
+    ClipJob cli_job;
+    RunConfig cfg;
+    bool debug = false;
+    bool quiet = false;
+    int cache_mb = 0;
+    int mem_mb = 0;
+    int outsize = 100;
+    std::string profile;
+    std::string job_file;
+    std::vector<std::string> creation_opts;
 
     // IMPORTANT: when addding a new option, don't forget to update the
     // short option, followed by colon if the argument is required.
-    const char* const short_opts = "hvi:o:c:m:d:p:n:g";
+    const char* const short_opts = "hvi:o:c:m:d:p:n:j:C:qrRSg";
 
     const option long_opts[] = {
         {"help",       no_argument,       nullptr, 'h'},
@@ -43,6 +507,20 @@ int main(int argc, char* argv[]) {
         {"datasets",   required_argument, nullptr, 'd'},
         {"pattern",    required_argument, nullptr, 'p'},
         {"label",      required_argument, nullptr, 'n'},
+        {"jobs",       required_argument, nullptr, 'j'},
+        {"resume",     no_argument,       nullptr, 'r'},
+        {"recursive",  no_argument,       nullptr, 'R'},
+        {"cache-mb",   required_argument, nullptr, 'C'},
+        {"stack",      no_argument,       nullptr, 'S'},
+        {"co",         required_argument, nullptr, OPT_CO},
+        {"profile",    required_argument, nullptr, OPT_PROFILE},
+        {"mask-exact", no_argument,       nullptr, OPT_MASK_EXACT},
+        {"stats",      no_argument,       nullptr, OPT_STATS},
+        {"outsize",    required_argument, nullptr, OPT_OUTSIZE},
+        {"manifest",   required_argument, nullptr, OPT_MANIFEST},
+        {"tap",        no_argument,       nullptr, OPT_TAP},
+        {"mem-limit",  required_argument, nullptr, OPT_MEM_LIMIT},
+        {"quiet",      no_argument,       nullptr, 'q'},
         {"debug",      no_argument,       nullptr, 'g'},
         {nullptr,      0,                 nullptr,  0 }
     };
@@ -61,29 +539,92 @@ int main(int argc, char* argv[]) {
                 print_version(APP_VERSION, APP_DATETIME);
                 return EXIT_SUCCESS;
             case 'i':
-                input_dir = optarg;
+                cli_job.input_dir = optarg;
                 break;
             case 'o':
-                output_dir = optarg;
+                cli_job.output_dir = optarg;
                 break;
             case 'c':
-                source_crs = optarg;
+                cli_job.source_crs = optarg;
                 break;
             case 'm':
-                mask_subset = optarg;
+                cli_job.mask = optarg;
                 break;
             case 'd':
-                datasets = optarg;
+                cli_job.datasets = optarg;
                 break;
             case 'p':
-                pattern = optarg;
+                cli_job.pattern = optarg;
                 break;
             case 'n':
-                label = optarg;
+                cli_job.label = optarg;
+                break;
+            case 'j':
+                cfg.jobs = std::atoi(optarg);
+                if (cfg.jobs < 1) {
+                    std::cerr << "ERROR: --jobs must be a positive integer.\n";
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'r':
+                cfg.resume = true;
+                break;
+            case 'R':
+                cfg.recursive = true;
+                break;
+            case 'C':
+                cache_mb = std::atoi(optarg);
+                if (cache_mb < 1) {
+                    std::cerr << "ERROR: --cache-mb must be a positive integer.\n";
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'S':
+                cfg.stack = true;
+                break;
+            case OPT_CO:
+                creation_opts.push_back(optarg);
+                break;
+            case OPT_MASK_EXACT:
+                cfg.mask_exact = true;
+                break;
+            case OPT_STATS:
+                statsEnable(true);
+                break;
+            case OPT_OUTSIZE:
+                outsize = std::atoi(optarg);
+                if (outsize < 1 || outsize > 100) {
+                    std::cerr << "ERROR: --outsize must be a percentage in 1..100.\n";
+                    return EXIT_FAILURE;
+                }
+                break;
+            case OPT_MANIFEST:
+                job_file = optarg;
+                break;
+            case OPT_TAP:
+                setTargetAlignedPixels(true);
+                break;
+            case OPT_MEM_LIMIT:
+                mem_mb = std::atoi(optarg);
+                if (mem_mb < 1) {
+                    std::cerr << "ERROR: --mem-limit must be a positive integer (MB).\n";
+                    return EXIT_FAILURE;
+                }
+                break;
+            case OPT_PROFILE:
+                profile = optarg;
+                if (profile != "default" && profile != "fast") {
+                    std::cerr << "ERROR: Unknown profile: " << profile
+                              << " (expected \"default\" or \"fast\").\n";
+                    return EXIT_FAILURE;
+                }
                 break;
             case 'g':
                 debug = true;
                 break;
+            case 'q':
+                quiet = true;
+                break;
             case '?': // Unrecognized option
             default:
                 print_help();
@@ -91,183 +632,146 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    std::cout << "clip - Clip TIF file bands from a single Landsat scene.\n";
+    // --quiet wins over --debug; otherwise --debug bumps the level up
+    logSetLevel(quiet ? LOG_QUIET : (debug ? LOG_VERBOSE : LOG_NORMAL));
 
-    // Check required arguments
+    LOG(LOG_NORMAL) << "clip - Clip TIF file bands from a single Landsat scene.\n";
 
-    if (input_dir.empty()) {
-        std::cerr << "ERROR: Input directory path is required.\n\n";
-        print_help();
-        return EXIT_FAILURE;
-    }
+    // Check required arguments (a job file supplies the rest per line)
 
-    if (output_dir.empty()) {
-        std::cerr << "ERROR: Output directory path is required.\n\n";
-        print_help();
-        return EXIT_FAILURE;
+    if (job_file.empty()) {
+        if (cli_job.input_dir.empty()) {
+            std::cerr << "ERROR: Input directory path is required.\n\n";
+            print_help();
+            return EXIT_FAILURE;
+        }
+
+        if (cli_job.output_dir.empty()) {
+            std::cerr << "ERROR: Output directory path is required.\n\n";
+            print_help();
+            return EXIT_FAILURE;
+        }
+
+        if (cli_job.mask.empty()) {
+            std::cout << "ERROR: Mask subset is required.\n";
+            print_help();
+            return EXIT_FAILURE;
+        }
+
+        if (cli_job.datasets.empty()) {
+            std::cout << "ERROR: Datasets are required.\n";
+            print_help();
+            return EXIT_FAILURE;
+        }
     }
 
-    if (source_crs.empty()) {
+    if (cli_job.source_crs.empty()) {
         std::cerr << "ERROR: Source CRS is required.\n\n";
         print_help();
         return EXIT_FAILURE;
     }
 
-    if (mask_subset.empty()) {
-        std::cout << "ERROR: Mask subset is required.\n";
-        print_help();
-        return EXIT_FAILURE;
-    }
+    // The session registers the GDAL/OGR drivers and caches the mask
+    // extent once for the whole run
+    ClipSession session;
 
-    if (datasets.empty()) {
-        std::cout << "ERROR: Datasets are required.\n";
-        print_help();
-        return EXIT_FAILURE;
+    // GDAL block cache budget, if requested (driver default otherwise)
+    if (cache_mb > 0) {
+        setClipCacheBudget(cache_mb);
     }
 
-    if (label.empty()) {
-        // Label to identify reprojected HDF files
-        label = "";
+    // Memory governor: clips reserve their estimated footprint against
+    // this budget before running. Unless --cache-mb set it explicitly,
+    // GDAL's block cache is capped to a quarter of the budget so it
+    // cannot grow past the limit on its own.
+    if (mem_mb > 0) {
+        setMemoryBudget(mem_mb);
+        if (cache_mb == 0) {
+            setClipCacheBudget(mem_mb / 4 > 0 ? mem_mb / 4 : 1);
+        }
     }
 
-    if (pattern.empty()) {
-        // Label to identify reprojected HDF files
-        pattern.clear();
+    // Output creation options: the fast profile writes tiled, compressed
+    // outputs with GDAL's internal multithreaded codec; explicit --co
+    // options come after it so they can override the profile
+    std::vector<std::string> output_opts;
+    if (profile == "fast") {
+        output_opts.push_back("TILED=YES");
+        output_opts.push_back("COMPRESS=DEFLATE");
+        output_opts.push_back("PREDICTOR=2");
+        output_opts.push_back("NUM_THREADS=ALL_CPUS");
     }
-
-    // Show initial parameters
-
-    std::cout << "Input directory: " << input_dir << "\n";
-    if (!directory_exists(input_dir)) {
-        std::cerr << "ERROR: Input directory not found: " << input_dir << std::endl;
-        return EXIT_FAILURE;
+    for (const std::string &co : creation_opts) {
+        output_opts.push_back(co);
     }
+    setCreationOptions(output_opts);
 
-    std::cout << "Output directory: " << output_dir << "\n";
-    if (!directory_exists(output_dir)) {
-        std::cerr << "ERROR: Output directory not found: " << output_dir << std::endl;
-        return EXIT_FAILURE;
+    // Reduced-resolution quicklook mode (full resolution by default)
+    if (outsize < 100) {
+        setOutputScale(outsize);
     }
 
-    std::cout << "Source CRS: " << source_crs << "\n";
-    std::cout << "Mask: " << mask_subset << "\n";
-    std::cout << "Label: " << label << "\n";
-    std::cout << "Pattern: " << pattern << "\n";
-    std::cout << "Debug: " << std::boolalpha << debug << "\n";
+    int rc = EXIT_SUCCESS;
 
-    list_datasets = split_by_commas(datasets);
-    if (list_datasets.empty()) {
-        std::cerr << "No datasets provided! Exiting.\n";
-        return EXIT_FAILURE;
-    }
-    std::cout << "Datasets: ";
-    for (std::string ds : list_datasets) {
-        std::cout << ds << " ";
-    }
-    std::cout << "\n";
-
-    // Initialize GDAL/OGR
-    GDALAllRegister();
-    OGRRegisterAll();
-
-    // Get extent from polygon
-    double minX, minY, maxX, maxY;
-    if (getShapefileExtent(mask_subset, minX, maxX, minY, maxY)) {
-        // Inflate the extent
-        minX -= 31;
-        minY -= 31;
-        maxX += 31;
-        maxY += 31;
-        std::cout << "Extent:\n";
-        std::cout << "minX=" << std::fixed << std::setprecision(15) << minX << ", minY="
-                  << minY << ", maxX=" << maxX << ", maxY=" << maxY << "\n";
+    if (job_file.empty()) {
+        rc = runClipJob(cli_job, cfg, session);
     } else {
-        std::cerr << "ERROR: Failed to read shapefile extent\n";
-        return EXIT_FAILURE;
-    }
-
-    std::vector<std::string> list_files = listFilesInDirectory(input_dir);
-    std::sort(list_files.begin(), list_files.end()); // Sort the list of files
-
-    for (std::string band : list_datasets) {
-
-        std::cout << "\n======Processing " << band << "======\n";
-
-        for (std::string &fname : list_files) {
-
-            // Filter by pattern, if provided but not found in file name, ignore this file & continue 
-            if (!pattern.empty() && !find_pattern(fname, pattern)) continue;
-            
-            // Create a filter for the band
-            std::string band_pattern =  "_" + band;
-            if (!find_pattern(fname, band_pattern)) continue;
-
-            std::cout << "File=" << fname << ", ";
-            // std::cout << "File kept=" << fname << "\n";
-
-            PathParts file_parts = splitPath(fname);
-            if (debug) {
-                std::cout << "Input filename: \n";
-                std::cout << "  Directory: " << file_parts.directory << "\n";
-                std::cout << "  Basename:  " << file_parts.basename << "\n";
-                std::cout << "  Stem:      " << file_parts.stem << "\n";
-                std::cout << "  Extension: " << file_parts.extension << "\n";
-            }
+        // --manifest: many jobs in one process. Driver registration, the
+        // CRS/MTL/extent caches and the dataset pool all carry over from
+        // job to job, so per-job startup cost is just the scan.
+        std::ifstream jobs_in(job_file);
+        if (!jobs_in.is_open()) {
+            std::cerr << "ERROR: Cannot open job file: " << job_file << "\n";
+            return EXIT_FAILURE;
+        }
 
-            if (file_parts.extension != ".tif") {
-                std::cout << "\".tif\" extension expected. Skipping.\n";
+        size_t job_no = 0, failed_jobs = 0;
+        std::string line;
+        while (std::getline(jobs_in, line)) {
+            // Strip surrounding whitespace before the blank/'#' checks
+            // and the field split: a CRLF job file would otherwise put
+            // '\r' into the last field (label or datasets), producing
+            // wrong output names with no diagnostic
+            size_t begin = line.find_first_not_of(" \t\r");
+            if (begin == std::string::npos) continue;
+            line.erase(line.find_last_not_of(" \t\r") + 1);
+            line.erase(0, begin);
+            if (line[0] == '#') continue;
+            job_no++;
+
+            ClipJob job;
+            if (!parseJobLine(line, cli_job, job)) {
+                std::cerr << "ERROR: Bad job line " << job_no
+                          << " (need idir;odir;mask;datasets).\n";
+                failed_jobs++;
                 continue;
             }
 
-            std::string projection;
-            int utm_zone = 0;
-
-            // parse metadata file
-            std::string metadataPath = locateMetadataFile(input_dir, fname);
-            if (!metadataPath.empty() && extractProjectionInfo(metadataPath, projection, utm_zone)) {
-                // Create CRS from the metadata file
-                std::cout << "Metadata=" << metadataPath << ", Proj=" << projection << ", Zone=" << utm_zone << "\n";
-                std::string temp_crs = getEPSGFromUTMZone(utm_zone);  // All Landsat are Northern hemisphere
-                std::cout << "  Source CRS=" << source_crs << ", temp CRS=" << temp_crs << "\n";
-                if (!temp_crs.empty() && (source_crs != temp_crs)) {
-                    // If valid temp_crs and different than the source CRS, replace the source CRS
-                    std::cout << "***Updating CRS " << source_crs << " with " << temp_crs << "\n";
-                    source_crs = temp_crs;
-                }
-            } else {
-                // Continue using default CRS
-                std::cout << "WARNING: Metadata not found or extraction faileded! Using source CRS=" << source_crs << "\n";
-            }
-
-            int epsgCode = parseEPSG(source_crs);
-            if (epsgCode == -1) {
-                std::cerr << "ERROR: Failed to get EPSG code.\n";
-                return EXIT_FAILURE;
-            }
-
-            // Create the input file name for clipping
-            std::string inFile = input_dir + file_parts.stem + file_parts.extension;
-            if (input_dir.back() != '/') {
-                inFile = input_dir + "/" + file_parts.stem + file_parts.extension;
-            }
-            // Create the input filename
-            std::string outFile = output_dir + file_parts.stem + label + file_parts.extension;
-            if (input_dir.back() != '/') {
-                outFile = output_dir + "/" + file_parts.stem + label + file_parts.extension;
+            LOG(LOG_NORMAL) << "\n======Job " << job_no << "======\n";
+            if (runClipJob(job, cfg, session) != EXIT_SUCCESS) {
+                std::cerr << "ERROR: Job " << job_no << " failed.\n";
+                failed_jobs++;
             }
+        }
 
-            std::cout << "inFile: " << inFile << "\n";
-            std::cout << "outFile: " << outFile << "\n";
-            std::cout << "epsgCode: " << epsgCode << "\n";
-
-            bool ok = clipRasterByBBox(inFile, outFile, minX, minY, maxX, maxY, epsgCode);
-            if (!ok) {
-                std::cerr << "ERROR: Failed to clip: " << fname << std::endl;
-                return EXIT_FAILURE;
-            }
+        logFlush();
+        std::cout << (job_no - failed_jobs) << " of " << job_no
+                  << " job(s) completed.\n";
+        if (failed_jobs > 0) {
+            rc = EXIT_FAILURE;
         }
     }
-  
+
+    // Sharded runs: tag the stats block with the rank so the per-rank
+    // reports can be merged downstream
+    int shard_rank, shard_size;
+    getShardInfo(shard_rank, shard_size);
+    if (shard_size > 1 && statsEnabled()) {
+        std::cout << "--- stats for rank " << shard_rank
+                  << " of " << shard_size << " ---\n";
+    }
+    statsReport();
+
     std::cout << "Ice never dies!" << std::endl;
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
+    return rc;
+}
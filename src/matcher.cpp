@@ -0,0 +1,71 @@
+#include <cstring>
+
+#include "matcher.hpp"
+
+void FileMatcher::compile(std::string_view pattern) {
+    alts.clear();
+
+    size_t start = 0;
+    while (start <= pattern.size()) {
+        size_t sep = pattern.find('|', start);
+        std::string_view part = pattern.substr(start, sep - start);
+
+        Alternative alt;
+        if (!part.empty() && part.front() == '^') {
+            alt.anchor_start = true;
+            part.remove_prefix(1);
+        }
+        if (!part.empty() && part.back() == '$') {
+            alt.anchor_end = true;
+            part.remove_suffix(1);
+        }
+        alt.needle.assign(part.data(), part.size());
+        if (!alt.needle.empty() || alt.anchor_start || alt.anchor_end) {
+            alts.push_back(std::move(alt));
+        }
+
+        if (sep == std::string_view::npos) break;
+        start = sep + 1;
+    }
+}
+
+// Substring scan on memchr for the first byte plus memcmp for the rest:
+// both run vectorized in libc, so the filter stays out of scan profiles
+// even on millions of names
+static bool containsNeedle(std::string_view hay, const std::string& needle) {
+    if (needle.size() > hay.size()) return false;
+    const char *h = hay.data();
+    const char *last = h + hay.size() - needle.size();
+    const char first = needle[0];
+    while (h <= last) {
+        const char *hit = (const char*)memchr(h, first, last - h + 1);
+        if (!hit) return false;
+        if (memcmp(hit + 1, needle.data() + 1, needle.size() - 1) == 0) {
+            return true;
+        }
+        h = hit + 1;
+    }
+    return false;
+}
+
+bool FileMatcher::matches(std::string_view name) const {
+    if (alts.empty()) return true;
+
+    for (const Alternative &alt : alts) {
+        const std::string &n = alt.needle;
+        if (n.size() > name.size()) continue;
+
+        if (alt.anchor_start && alt.anchor_end) {
+            if (n.size() == name.size() &&
+                memcmp(name.data(), n.data(), n.size()) == 0) return true;
+        } else if (alt.anchor_start) {
+            if (memcmp(name.data(), n.data(), n.size()) == 0) return true;
+        } else if (alt.anchor_end) {
+            if (memcmp(name.data() + name.size() - n.size(),
+                       n.data(), n.size()) == 0) return true;
+        } else {
+            if (n.empty() || containsNeedle(name, n)) return true;
+        }
+    }
+    return false;
+}
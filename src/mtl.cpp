@@ -0,0 +1,122 @@
+#include <cstdlib>
+#include <fstream>
+
+#include "mtl.hpp"
+#include "utils.hpp"
+
+#include "cpl_vsi.h"
+
+static std::string_view trimView(std::string_view s) {
+    size_t begin = s.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos) {
+        return std::string_view();  // all whitespace
+    }
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(begin, end - begin + 1);
+}
+
+bool MTLFile::load(const std::string& path) {
+    loaded = false;
+    values.clear();
+
+    // ifstream cannot open object-store paths; the /vsi branch goes
+    // through GDAL's virtual filesystem instead
+    if (isVSIPath(path)) {
+        VSILFILE *file = VSIFOpenL(path.c_str(), "rb");
+        if (!file) {
+            return false;
+        }
+        VSIFSeekL(file, 0, SEEK_END);
+        vsi_l_offset size = VSIFTellL(file);
+        VSIFSeekL(file, 0, SEEK_SET);
+        buffer.resize((size_t)size);
+        bool ok = (size == 0 ||
+                   VSIFReadL(&buffer[0], 1, (size_t)size, file) == (size_t)size);
+        VSIFCloseL(file);
+        if (!ok) {
+            return false;
+        }
+    } else {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            return false;
+        }
+        std::streamsize size = file.tellg();
+        file.seekg(0);
+        buffer.resize((size_t)size);
+        if (size > 0 && !file.read(&buffer[0], size)) {
+            return false;
+        }
+    }
+
+    // One pass over the buffer: split into lines, trim, take KEY = VALUE.
+    // GROUP/END_GROUP/END lines have no '=' value worth keeping (GROUP
+    // does, but its value is the group name, which we flatten away).
+    std::string_view rest(buffer);
+    while (!rest.empty()) {
+        size_t eol = rest.find('\n');
+        std::string_view line = rest.substr(0, eol);
+        rest = (eol == std::string_view::npos)
+            ? std::string_view()
+            : rest.substr(eol + 1);
+
+        line = trimView(line);
+        if (line.empty()) continue;
+
+        size_t eq = line.find('=');
+        if (eq == std::string_view::npos) continue;
+
+        std::string_view key = trimView(line.substr(0, eq));
+        std::string_view value = trimView(line.substr(eq + 1));
+        if (key.empty() || key == "GROUP" || key == "END_GROUP") continue;
+
+        values.emplace(key, value);  // first occurrence wins
+    }
+
+    loaded = true;
+    return true;
+}
+
+bool MTLFile::getString(std::string_view key, std::string& value) const {
+    auto it = values.find(key);
+    if (it == values.end()) {
+        return false;
+    }
+    std::string_view v = it->second;
+    if (v.size() >= 2 && v.front() == '"' && v.back() == '"') {
+        v = v.substr(1, v.size() - 2);
+    }
+    value.assign(v.data(), v.size());
+    return true;
+}
+
+bool MTLFile::getInt(std::string_view key, int& value) const {
+    auto it = values.find(key);
+    if (it == values.end() || it->second.empty()) {
+        return false;
+    }
+    // The view is not null-terminated; a small copy keeps strtol safe
+    std::string v(it->second);
+    char *end = nullptr;
+    long parsed = strtol(v.c_str(), &end, 10);
+    if (end == v.c_str()) {
+        return false;
+    }
+    value = (int)parsed;
+    return true;
+}
+
+bool MTLFile::getDouble(std::string_view key, double& value) const {
+    auto it = values.find(key);
+    if (it == values.end() || it->second.empty()) {
+        return false;
+    }
+    std::string v(it->second);
+    char *end = nullptr;
+    double parsed = strtod(v.c_str(), &end);
+    if (end == v.c_str()) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "stats.hpp"
+
+static bool stats_enabled = false;
+static std::map<std::string, std::vector<double>> stage_samples;
+static std::mutex stats_mutex;
+static std::atomic<unsigned long long> bytes_read(0);
+static std::atomic<unsigned long long> bytes_written(0);
+
+void statsEnable(bool on) {
+    stats_enabled = on;
+}
+
+bool statsEnabled() {
+    return stats_enabled;
+}
+
+void statsRecord(const char *stage, double seconds) {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    stage_samples[stage].push_back(seconds);
+}
+
+void statsAddBytesRead(unsigned long long bytes) {
+    if (stats_enabled) bytes_read += bytes;
+}
+
+void statsAddBytesWritten(unsigned long long bytes) {
+    if (stats_enabled) bytes_written += bytes;
+}
+
+void statsReport() {
+    if (!stats_enabled) return;
+
+    std::lock_guard<std::mutex> lock(stats_mutex);
+
+    printf("\n---- Timing summary ----\n");
+    printf("%-12s %8s %12s %12s %12s\n",
+           "stage", "count", "total(s)", "mean(ms)", "p95(ms)");
+
+    for (auto &entry : stage_samples) {
+        std::vector<double> samples = entry.second;
+        std::sort(samples.begin(), samples.end());
+
+        double total = 0.0;
+        for (double s : samples) total += s;
+
+        size_t n = samples.size();
+        size_t p95_idx = (size_t)(0.95 * n);
+        if (p95_idx >= n) p95_idx = n - 1;
+
+        printf("%-12s %8zu %12.3f %12.3f %12.3f\n",
+               entry.first.c_str(), n, total,
+               1000.0 * total / n, 1000.0 * samples[p95_idx]);
+    }
+
+    printf("Bytes read: %.1f MB, bytes written: %.1f MB\n",
+           bytes_read / (1024.0 * 1024.0),
+           bytes_written / (1024.0 * 1024.0));
+}
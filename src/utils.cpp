@@ -1,11 +1,23 @@
 #include <iostream>
 #include <dirent.h>
+#include <sys/stat.h>
 #include <fstream>
-
+#include <algorithm>
+#include <condition_variable>
+#include <thread>
+#include <iomanip>
+#include <map>
+#include <mutex>
+
+#include "catalog.hpp"
+#include "log.hpp"
+#include "matcher.hpp"
+#include "mtl.hpp"
 #include "utils.hpp"
 
 #include "gdal_utils.h"
 #include "cpl_conv.h"
+#include "cpl_vsi.h"
 #include "ogrsf_frmts.h"
 
 void print_help() {
@@ -17,8 +29,31 @@ void print_help() {
               << "  -c, --source_crs STR   Source coordinate reference system (e.g. \"EPSG:32615\")\n"
               << "  -m, --mask FILE        Specify a mask file (*.shp)\n"
               << "  -d, --datasets LIST    List of datasets (comma separated)\n"
-              << "  -p, --pattern STR      Pattern to filter files to process\n"
+              << "  -p, --pattern STR      Pattern to filter files to process (substring;\n"
+              << "                         supports ^/$ anchors and | alternatives)\n"
               << "  -n, --label STR        Label for output files\n"
+              << "  -j, --jobs N           Number of parallel clip workers (default 1)\n"
+              << "  -r, --resume           Skip outputs that are already up to date\n"
+              << "  -R, --recursive        Scan input directory recursively (parallel walk)\n"
+              << "  -C, --cache-mb N       GDAL raster block cache size in MB\n"
+              << "  -S, --stack            Write one multi-band output per scene\n"
+              << "      --co KEY=VALUE     Output creation option (repeatable)\n"
+              << "      --mask-exact       Mask pixels outside the polygon during the clip\n"
+              << "      --stats            Print a per-stage timing summary at the end\n"
+              << "      --manifest FILE    Run many clip jobs from FILE in one process,\n"
+              << "                         one per line: idir;odir;mask;datasets[;pattern\n"
+              << "                         [;label]] (empty fields use the CLI arguments)\n"
+              << "      --mem-limit MB     Memory budget: workers reserve their window's\n"
+              << "                         footprint against it and oversized windows are\n"
+              << "                         streamed in block rows\n"
+              << "      --tap              Snap the clip window to the pixel grid so all\n"
+              << "                         scenes get identical aligned windows\n"
+              << "      --outsize PCT      Reduced-resolution output, PCT percent of the\n"
+              << "                         clip size (average resampled, reads source\n"
+              << "                         overviews when present)\n"
+              << "  -q, --quiet            Only print errors and the final summary\n"
+              << "      --profile NAME     Output profile: default, or fast (tiled +\n"
+              << "                         DEFLATE with multithreaded compression)\n"
               << "  -v, --version          Show version information\n"
               << "  -h, --help             Show this help message\n"
               << std::endl;
@@ -103,6 +138,30 @@ PathParts splitPath(const std::string& path) {
     return parts;
 }
 
+PathPartsView splitPathView(std::string_view path) {
+    // Same splitting rules as splitPath(), but the parts are views into
+    // the caller's string: no allocation, no copies
+    PathPartsView parts;
+
+    size_t slashPos = path.find_last_of("/\\");
+    if (slashPos == std::string_view::npos) {
+        parts.basename = path;  // no directory
+    } else {
+        parts.directory = path.substr(0, slashPos);
+        parts.basename = path.substr(slashPos + 1);
+    }
+
+    size_t dotPos = parts.basename.find_last_of('.');
+    if (dotPos == std::string_view::npos) {
+        parts.stem = parts.basename;  // no extension
+    } else {
+        parts.stem = parts.basename.substr(0, dotPos);
+        parts.extension = parts.basename.substr(dotPos);
+    }
+
+    return parts;
+}
+
 bool directory_exists(const std::string& path) {
     struct stat info;
     if (stat(path.c_str(), &info) != 0) {
@@ -111,19 +170,38 @@ bool directory_exists(const std::string& path) {
     return (info.st_mode & S_IFDIR) != 0;
 }
 
-bool ends_with(const std::string &str, const std::string &suffix) {
+bool ends_with(std::string_view str, std::string_view suffix) {
     if (suffix.size() > str.size()) return false;
     return std::equal(suffix.rbegin(), suffix.rend(), str.rbegin());
 }
 
-bool find_pattern(const std::string& filename, const std::string& pattern) {
+bool find_pattern(std::string_view filename, std::string_view pattern) {
     // Returns true if 'pattern' is found anywhere inside 'filename'.
-    return filename.find(pattern) != std::string::npos;
+    return filename.find(pattern) != std::string_view::npos;
+}
+
+bool isVSIPath(std::string_view path) {
+    // GDAL virtual filesystem path (/vsis3/, /vsicurl/, /vsigs/, ...)
+    return path.compare(0, 4, "/vsi") == 0;
 }
 
 // ---------- Utility: list files in directory (POSIX) -------------
 std::vector<std::string> listFilesInDirectory(const std::string& dirPath) {
     std::vector<std::string> files;
+
+    // Object-store inputs go through GDAL's virtual filesystem; one
+    // ListObjects call instead of POSIX readdir
+    if (isVSIPath(dirPath)) {
+        char **names = VSIReadDir(dirPath.c_str());
+        for (int i = 0; names && names[i]; ++i) {
+            std::string name(names[i]);
+            if (name == "." || name == "..") continue;
+            files.push_back(name);
+        }
+        CSLDestroy(names);
+        return files;
+    }
+
     DIR* dir = opendir(dirPath.c_str());
     if (!dir) {
         perror(("opendir: " + dirPath).c_str());
@@ -139,7 +217,225 @@ std::vector<std::string> listFilesInDirectory(const std::string& dirPath) {
     return files;
 }
 
+// Parallel recursive scan: a shared stack of pending subdirectories, one
+// task per directory, N threads. Only *.tif entries are collected (the
+// filter runs during the walk), as paths relative to the scan root.
+namespace {
+struct ScanState {
+    std::vector<std::string> dirs;    // pending directories, relative to root
+    std::vector<std::string> files;   // collected *.tif files, relative to root
+    std::vector<std::string> visited; // every directory the walk entered
+    std::mutex mutex;
+    std::condition_variable cv;
+    int active = 0;                   // workers currently inside readdir
+};
+
+void scanWorker(const std::string& root, ScanState& state) {
+    std::unique_lock<std::mutex> lock(state.mutex);
+    while (true) {
+        while (state.dirs.empty() && state.active > 0) {
+            state.cv.wait(lock);
+        }
+        if (state.dirs.empty()) {
+            return; // nothing pending and nobody can produce more
+        }
+        std::string rel = state.dirs.back();
+        state.dirs.pop_back();
+        state.visited.push_back(rel);
+        state.active++;
+        lock.unlock();
+
+        std::string full = root;
+        if (!rel.empty()) {
+            if (full.back() != '/') full += "/";
+            full += rel;
+        }
+
+        std::vector<std::string> new_dirs;
+        std::vector<std::string> new_files;
+
+        DIR* dir = opendir(full.c_str());
+        if (dir) {
+            struct dirent* entry;
+            while ((entry = readdir(dir)) != nullptr) {
+                std::string name(entry->d_name);
+                if (name == "." || name == "..") continue;
+
+                std::string relName = rel.empty() ? name : rel + "/" + name;
+
+                bool is_dir;
+                if (entry->d_type != DT_UNKNOWN) {
+                    is_dir = (entry->d_type == DT_DIR);
+                } else {
+                    // Filesystem doesn't fill d_type, fall back to stat
+                    struct stat info;
+                    std::string fullName = full;
+                    if (fullName.back() != '/') fullName += "/";
+                    fullName += name;
+                    is_dir = (stat(fullName.c_str(), &info) == 0 &&
+                              (info.st_mode & S_IFDIR) != 0);
+                }
+
+                if (is_dir) {
+                    new_dirs.push_back(std::move(relName));
+                } else if (ends_with(name, ".tif")) {
+                    new_files.push_back(std::move(relName));
+                }
+            }
+            closedir(dir);
+        } else {
+            perror(("opendir: " + full).c_str());
+        }
+
+        lock.lock();
+        state.active--;
+        for (auto &d : new_dirs) {
+            state.dirs.push_back(std::move(d));
+        }
+        for (auto &f : new_files) {
+            state.files.push_back(std::move(f));
+        }
+        state.cv.notify_all();
+    }
+}
+} // namespace
+
+std::vector<std::string> listFilesRecursive(const std::string& dirPath,
+                                            unsigned int numThreads,
+                                            std::vector<std::string>* scannedDirs) {
+    // Object stores have no real directories: one recursive listing call
+    // replaces the threaded walk (and is far cheaper than per-"subdir"
+    // requests). Filter to *.tif like the POSIX walk does.
+    if (isVSIPath(dirPath)) {
+        std::vector<std::string> files;
+        char **names = VSIReadDirRecursive(dirPath.c_str());
+        for (int i = 0; names && names[i]; ++i) {
+            std::string name(names[i]);
+            if (ends_with(name, ".tif")) {
+                files.push_back(name);
+            }
+        }
+        CSLDestroy(names);
+        return files;
+    }
+
+    ScanState state;
+    state.dirs.push_back(""); // start at the root
+
+    if (numThreads < 1) numThreads = 1;
+    if (numThreads == 1) {
+        scanWorker(dirPath, state);
+    } else {
+        std::vector<std::thread> scanners;
+        scanners.reserve(numThreads);
+        for (unsigned int i = 0; i < numThreads; ++i) {
+            scanners.emplace_back(scanWorker, std::ref(dirPath), std::ref(state));
+        }
+        for (auto &t : scanners) {
+            t.join();
+        }
+    }
+
+    if (scannedDirs) {
+        *scannedDirs = std::move(state.visited);
+    }
+    return std::move(state.files);
+}
+
+FileIndex buildFileIndex(const std::string& dirPath, const std::string& pattern,
+                         bool recursive, unsigned int scanThreads) {
+    FileIndex index;
+
+    // A valid scene catalog replaces the directory walk entirely; it is
+    // rebuilt below whenever the directory mtimes say it is stale
+    std::vector<std::string> names;
+    bool from_catalog = sceneCatalogLoad(dirPath, recursive, names);
+
+    // Every directory the walk enters guards the rebuilt catalog, so a
+    // new scene directory under a previously empty intermediate level
+    // still invalidates it
+    std::vector<std::string> scanned_dirs;
+    if (!from_catalog) {
+        names = recursive
+            ? listFilesRecursive(dirPath, scanThreads, &scanned_dirs)
+            : listFilesInDirectory(dirPath);
+    }
+
+    // The catalog stores every *.tif unfiltered, so runs with different
+    // patterns can share it
+    std::vector<std::string> tif_names;
+
+    // Pattern compiled once for the whole scan (supports ^/$ anchors and
+    // '|' alternatives; plain text keeps the old substring behavior)
+    FileMatcher matcher;
+    matcher.compile(pattern);
+
+    // Single pass: filter extension and pattern during the walk and group
+    // files by their band suffix, so the per-band loop is a lookup instead
+    // of an O(bands x files) substring scan
+    for (const std::string &name : names) {
+        // In recursive mode 'name' keeps its subdirectory prefix; the
+        // band suffix always comes from the basename
+        PathPartsView parts = splitPathView(name);
+        if (parts.extension != ".tif") continue;
+        if (!from_catalog) tif_names.push_back(name);
+        if (!matcher.matches(name)) continue;
+
+        // Landsat naming: 40-char scene ID, '_', then the band designator
+        // (e.g. SR_B4, QA_PIXEL, B10). Anything that doesn't follow the
+        // convention is grouped under its full stem so it can still match.
+        std::string_view suffix = parts.stem;
+        if (suffix.size() > 41 && suffix[40] == '_') {
+            suffix = suffix.substr(41);
+        }
+
+        // Group keys materialize only on first sight of a new suffix
+        // (~15 per archive); the steady-state loop allocates nothing
+        // beyond the stored file name itself
+        auto it = index.bySuffix.find(suffix);
+        if (it == index.bySuffix.end()) {
+            it = index.bySuffix.emplace(std::string(suffix),
+                                        std::vector<std::string>()).first;
+        }
+        it->second.push_back(name);
+    }
+
+    // Keep deterministic processing order within each group
+    for (auto &entry : index.bySuffix) {
+        std::sort(entry.second.begin(), entry.second.end());
+    }
+
+    if (!from_catalog) {
+        sceneCatalogBuild(dirPath, tif_names, recursive, scanned_dirs);
+    }
+
+    return index;
+}
+
+std::vector<std::string> filesForBand(const FileIndex& index, const std::string& band) {
+    std::vector<std::string> files;
+
+    // Match against the handful of distinct suffixes (~15 per archive),
+    // not against every file name. Same semantics as before: the band
+    // pattern "_<band>" may appear anywhere in the suffix.
+    std::string band_pattern = "_" + band;
+    for (const auto &entry : index.bySuffix) {
+        if (find_pattern("_" + entry.first, band_pattern)) {
+            files.insert(files.end(), entry.second.begin(), entry.second.end());
+        }
+    }
+
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
 bool fileExists(const std::string& filename) {
+    // ifstream cannot see /vsi paths, which would make the MTL lookup
+    // fail for every object-store scene; stat those through GDAL
+    if (isVSIPath(filename)) {
+        VSIStatBufL st;
+        return VSIStatL(filename.c_str(), &st) == 0;
+    }
     std::ifstream file(filename);
     return file.good(); // Checks if the file is open and in a good state
 }
@@ -166,57 +462,78 @@ std::string locateMetadataFile(const std::string& dirPath, const std::string& ti
 }
 
 bool extractProjectionInfo(const std::string& filename, std::string& projection, int& utmZone) {
-    
-    // std::cout << "Metadata=" << filename << " ";
-
-    // Open the file for reading
-    std::ifstream file(filename);
-    
-    // Check if the file opened successfully
-    if (!file.is_open()) {
+    // Single-buffer MTL parse instead of the old getline/find/substr
+    // loop (which also crashed on all-whitespace lines)
+    MTLFile mtl;
+    if (!mtl.load(filename)) {
         std::cerr << "ERROR: Failed to open file: " << filename << std::endl;
         return false;
     }
 
-    std::string line;
-
-    // Read the file line by line
-    while (std::getline(file, line)) {
-        // Remove leading and trailing whitespaces from the line
-        line = line.substr(line.find_first_not_of(" \t"), line.find_last_not_of(" \t") + 1);
-
-        // Check for MAP_PROJECTION and extract value
-        if (line.find("MAP_PROJECTION") != std::string::npos) {
-            // Extract value after "=" and remove quotes
-            size_t startPos = line.find("=") + 1;
-            // size_t endPos = line.find("\"", startPos + 1);
-            // projection = line.substr(startPos + 1, endPos - startPos - 1);
-            projection = stripString(line.substr(startPos));
-            // std::cout << " startPos=" << startPos ;
-            // std::cout << " proj=" << projection << " ";
-        }
+    // Return true only if both the projection and UTM zone are present
+    return mtl.getString("MAP_PROJECTION", projection) &&
+           mtl.getInt("UTM_ZONE", utmZone) &&
+           !projection.empty() && utmZone != 0;
+}
 
-        // Check for UTM_ZONE and extract value
-        if (line.find("UTM_ZONE") != std::string::npos) {
-            // Extract the integer value after "="
-            size_t startPos = line.find("=") + 1;
-            // std::cout << "utmZone str=" << line.substr(startPos) << " ";
-            utmZone = std::stoi(line.substr(startPos));
-            // std::cout << "utmZone=" << utmZone << "\n";
-        }
+// Scene-level metadata cache. A scene has ~11 band files sharing one
+// _MTL.txt; without the cache the same small file is opened and
+// line-scanned once per band, which is painful on NFS archives. Negative
+// results are cached too, so a missing MTL is probed only once per scene.
+namespace {
+struct SceneMetadata {
+    bool valid = false;
+    std::string projection;
+    int utmZone = 0;
+};
+} // namespace
+
+static std::map<std::string, SceneMetadata> mtl_cache;
+static std::mutex mtl_cache_mutex;
+
+bool getSceneProjectionInfo(const std::string& dirPath,
+                            const std::string& tifFilename,
+                            std::string& projection, int& utmZone) {
+    // A valid scene catalog has the zone baked in from its build pass,
+    // so no MTL file is touched at all
+    int catalog_zone = 0;
+    if (sceneCatalogZone(dirPath, tifFilename, catalog_zone)) {
+        projection = "UTM";  // Landsat L2 products are always UTM
+        utmZone = catalog_zone;
+        return true;
+    }
 
-        // If both projection and utmZone are found, break out of the loop
-        if (!projection.empty() && utmZone != 0) {
-            // std::cout << "Found, exiting.\n";
-            break;
+    // The file may carry a subdirectory prefix from a recursive scan; the
+    // MTL sits next to the band file, and the scene ID is the 40-char
+    // basename prefix that locateMetadataFile() uses
+    PathParts parts = splitPath(tifFilename);
+    std::string sceneDir = dirPath;
+    if (!parts.directory.empty()) {
+        if (sceneDir.back() != '/') sceneDir += "/";
+        sceneDir += parts.directory;
+    }
+    std::string sceneId = parts.basename.substr(0, 40);
+    std::string key = sceneDir + "/" + sceneId;
+
+    std::lock_guard<std::mutex> lock(mtl_cache_mutex);
+
+    auto it = mtl_cache.find(key);
+    if (it == mtl_cache.end()) {
+        SceneMetadata meta;
+        std::string metadataPath = locateMetadataFile(sceneDir, parts.basename);
+        if (!metadataPath.empty()) {
+            meta.valid = extractProjectionInfo(metadataPath,
+                                               meta.projection, meta.utmZone);
         }
+        it = mtl_cache.insert(std::make_pair(key, meta)).first;
     }
 
-    // Close the file
-    file.close();
-
-    // Return true if both the projection and UTM zone were extracted
-    return !projection.empty() && utmZone != 0;
+    if (!it->second.valid) {
+        return false;
+    }
+    projection = it->second.projection;
+    utmZone = it->second.utmZone;
+    return true;
 }
 
 std::string stripString(const std::string& input) {
@@ -242,6 +559,76 @@ std::string stripString(const std::string& input) {
     return result;
 }
 
+// Size and mtime of a local or /vsi path: POSIX stat() cannot see
+// object-store inputs, which would leave --resume and the cost hints
+// blind on exactly the archives the /vsi support targets
+static bool statAnyPath(const std::string& path,
+                        long long& size, long long& mtime) {
+    if (isVSIPath(path)) {
+        VSIStatBufL st;
+        if (VSIStatL(path.c_str(), &st) != 0) {
+            return false;
+        }
+        size = (long long)st.st_size;
+        mtime = (long long)st.st_mtime;
+        return true;
+    }
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    size = (long long)st.st_size;
+    mtime = (long long)st.st_mtime;
+    return true;
+}
+
+long long getFileSize(const std::string& path) {
+    long long size, mtime;
+    return statAnyPath(path, size, mtime) ? size : -1;
+}
+
+bool outputUpToDate(const std::string& inFile, const std::string& outFile) {
+    long long in_size, in_mtime, out_size, out_mtime;
+
+    if (!statAnyPath(outFile, out_size, out_mtime)) {
+        return false; // no output yet
+    }
+    if (out_size == 0) {
+        return false; // empty output, probably a killed run
+    }
+    if (!statAnyPath(inFile, in_size, in_mtime)) {
+        return false; // cannot stat input, let the clip report the error
+    }
+    // Output older than input means the input was replaced: redo it
+    return out_mtime >= in_mtime;
+}
+
+bool readClipManifest(const std::string& manifestFile,
+                      double &minX, double &minY,
+                      double &maxX, double &maxY,
+                      int &epsgCode) {
+    std::ifstream file(manifestFile);
+    if (!file.is_open()) {
+        return false;
+    }
+    file >> minX >> minY >> maxX >> maxY >> epsgCode;
+    return !file.fail();
+}
+
+bool writeClipManifest(const std::string& manifestFile,
+                       double minX, double minY,
+                       double maxX, double maxY,
+                       int epsgCode) {
+    std::ofstream file(manifestFile);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << std::setprecision(17)
+         << minX << " " << minY << " " << maxX << " " << maxY << " "
+         << epsgCode << "\n";
+    return file.good();
+}
+
 // Function to create an EPSG string from a UTM zone and hemisphere (Northern or Southern)
 std::string getEPSGFromUTMZone(int zone, bool isSouthernHemisphere) {
 
@@ -256,6 +643,48 @@ std::string getEPSGFromUTMZone(int zone, bool isSouthernHemisphere) {
     return "EPSG:" + std::to_string(epsgCode);
 }
 
+// EPSG -> WKT cache. importFromEPSG() hits the PROJ database (SQLite
+// lookups) every time, but a run over one path/row resolves the same
+// code for every scene, so resolve each code once and reuse it.
+static std::map<int, std::string> wkt_cache;
+static std::mutex wkt_cache_mutex;
+
+std::string getWKTFromEPSG(int epsgCode) {
+    std::lock_guard<std::mutex> lock(wkt_cache_mutex);
+
+    auto it = wkt_cache.find(epsgCode);
+    if (it != wkt_cache.end()) {
+        return it->second;
+    }
+
+    OGRSpatialReference srs;
+    if (srs.importFromEPSG(epsgCode) != OGRERR_NONE) {
+        return "";
+    }
+    char *wkt = nullptr;
+    srs.exportToWkt(&wkt);
+    std::string result = wkt ? wkt : "";
+    CPLFree(wkt);
+
+    wkt_cache[epsgCode] = result;
+    return result;
+}
+
+namespace {
+// Per-thread GDALTranslateOptions cache: the options only depend on the
+// bbox and EPSG code, which are constant across a run, so rebuild them
+// only when one of those actually changes
+struct TranslateOptionsCache {
+    double minX = 0, minY = 0, maxX = 0, maxY = 0;
+    int epsg = -1;
+    GDALTranslateOptions *opts = nullptr;
+
+    ~TranslateOptionsCache() {
+        if (opts) GDALTranslateOptionsFree(opts);
+    }
+};
+} // namespace
+
 bool clipRasterByBBox(const std::string& inFile,
                       const std::string& outFile,
                       double minX, double minY,
@@ -268,42 +697,57 @@ bool clipRasterByBBox(const std::string& inFile,
     if (!src)
         return false;
 
-    // ---- Build projection WKT from EPSG ----
-    OGRSpatialReference srs;
-    srs.importFromEPSG(epsgCode);
-    char *wkt = nullptr;
-    srs.exportToWkt(&wkt);
+    static thread_local TranslateOptionsCache cache;
 
-    // ---- Build ONLY GDALTranslate option strings ----
-    std::vector<std::string> optStrs = {
-        "-projwin",
-        std::to_string(minX),
-        std::to_string(maxY),
-        std::to_string(maxX),
-        std::to_string(minY),
-        "-a_srs",
-        std::string(wkt)
-    };
-
-    // Convert to char* array
-    std::vector<char*> opts;
-    for (auto &s : optStrs)
-        opts.push_back(&s[0]);
-    opts.push_back(nullptr);
-
-    GDALTranslateOptions *trOpts =
-        GDALTranslateOptionsNew(opts.data(), nullptr);
+    if (!cache.opts || cache.epsg != epsgCode ||
+        cache.minX != minX || cache.minY != minY ||
+        cache.maxX != maxX || cache.maxY != maxY) {
+
+        // ---- Projection WKT from EPSG (cached across all clip calls) ----
+        std::string wkt = getWKTFromEPSG(epsgCode);
+        if (wkt.empty()) {
+            std::cerr << "ERROR: Cannot resolve EPSG:" << epsgCode << "\n";
+            GDALClose(src);
+            return false;
+        }
+
+        // ---- Build ONLY GDALTranslate option strings ----
+        std::vector<std::string> optStrs = {
+            "-projwin",
+            std::to_string(minX),
+            std::to_string(maxY),
+            std::to_string(maxX),
+            std::to_string(minY),
+            "-a_srs",
+            wkt
+        };
+
+        // Convert to char* array
+        std::vector<char*> opts;
+        for (auto &s : optStrs)
+            opts.push_back(&s[0]);
+        opts.push_back(nullptr);
+
+        if (cache.opts) GDALTranslateOptionsFree(cache.opts);
+        cache.opts = GDALTranslateOptionsNew(opts.data(), nullptr);
+        cache.minX = minX;
+        cache.minY = minY;
+        cache.maxX = maxX;
+        cache.maxY = maxY;
+        cache.epsg = epsgCode;
+    }
 
     // ---- Correct call: filenames NOT in options ----
     GDALDataset *outDs = (GDALDataset*)GDALTranslate(
         outFile.c_str(),  // output file from argument
         src,              // input dataset
-        trOpts,           // options
+        cache.opts,       // options (reused while bbox/EPSG unchanged)
         nullptr
     );
 
-    GDALTranslateOptionsFree(trOpts);
-    CPLFree(wkt);
+    // Close the output too: with thousands of clips per process, leaked
+    // handles pile up and unflushed outputs only hit disk at exit
+    if (outDs) GDALClose(outDs);
     GDALClose(src);
 
     return (outDs != nullptr);
@@ -322,12 +766,55 @@ int parseEPSG(const std::string& epsgStr)
     }
 }
 
+// Sidecar cache next to the shapefile: holds the shapefile's mtime and
+// the computed extent, so repeated runs with the same mask skip OGROpen
+// (on network filesystems the open alone is expensive)
+static std::string extentCachePath(const std::string& shpFile) {
+    return shpFile + ".extent";
+}
+
+static bool readExtentCache(const std::string& shpFile, long mtime,
+                            double &xmin, double &xmax,
+                            double &ymin, double &ymax)
+{
+    std::ifstream cache(extentCachePath(shpFile));
+    if (!cache.is_open()) {
+        return false;
+    }
+    long cached_mtime = 0;
+    if (!(cache >> cached_mtime >> xmin >> xmax >> ymin >> ymax)) {
+        return false; // malformed, recompute
+    }
+    return cached_mtime == mtime;
+}
+
+static void writeExtentCache(const std::string& shpFile, long mtime,
+                             double xmin, double xmax,
+                             double ymin, double ymax)
+{
+    // Best effort: a read-only mask directory just means no cache
+    std::ofstream cache(extentCachePath(shpFile));
+    if (!cache.is_open()) {
+        return;
+    }
+    cache << mtime << " " << std::setprecision(17)
+          << xmin << " " << xmax << " " << ymin << " " << ymax << "\n";
+}
+
 bool getShapefileExtent(const std::string& shpFile,
                         double &xmin, double &xmax,
                         double &ymin, double &ymax)
 {
     // OGRRegisterAll();
 
+    struct stat shp_stat;
+    long mtime = (stat(shpFile.c_str(), &shp_stat) == 0) ? (long)shp_stat.st_mtime : 0;
+
+    if (mtime != 0 && readExtentCache(shpFile, mtime, xmin, xmax, ymin, ymax)) {
+        LOG(LOG_NORMAL) << "xmin: " << xmin << ", ymin: " << ymin << ", xmax: " << xmax << ", ymax" << ymax << " (cached)\n";
+        return true;
+    }
+
     // Open dataset
     GDALDataset *ds = (GDALDataset*)OGROpen(shpFile.c_str(), FALSE, nullptr);
     if (!ds) {
@@ -343,35 +830,48 @@ bool getShapefileExtent(const std::string& shpFile,
         return false;
     }
 
+    // Union the envelopes of every feature in one layer pass, so masks
+    // with multiple polygons (e.g. several fields) work too
+    bool have_extent = false;
     layer->ResetReading();
-    OGRFeature *feat = layer->GetNextFeature();
-    if (!feat) {
-        std::cerr << "ERROR: No features in shapefile\n";
-        GDALClose(ds);
-        return false;
-    }
+    OGRFeature *feat;
+    while ((feat = layer->GetNextFeature()) != nullptr) {
+        OGRGeometry *geom = feat->GetGeometryRef();
+        if (!geom) {
+            OGRFeature::DestroyFeature(feat);
+            continue;
+        }
 
-    OGRGeometry *geom = feat->GetGeometryRef();
-    if (!geom) {
-        std::cerr << "ERROR: No geometry in shapefile\n";
+        OGREnvelope env;
+        geom->getEnvelope(&env);
+        if (!have_extent) {
+            xmin = env.MinX;
+            xmax = env.MaxX;
+            ymin = env.MinY;
+            ymax = env.MaxY;
+            have_extent = true;
+        } else {
+            xmin = std::min(xmin, env.MinX);
+            xmax = std::max(xmax, env.MaxX);
+            ymin = std::min(ymin, env.MinY);
+            ymax = std::max(ymax, env.MaxY);
+        }
         OGRFeature::DestroyFeature(feat);
+    }
+
+    if (!have_extent) {
+        std::cerr << "ERROR: No features with geometry in shapefile\n";
         GDALClose(ds);
         return false;
     }
 
-    // Extract envelope (bounding box)
-    OGREnvelope env;
-    geom->getEnvelope(&env);
-
-    xmin = env.MinX;
-    xmax = env.MaxX;
-    ymin = env.MinY;
-    ymax = env.MaxY;
-
-    std::cout << "xmin: " << xmin << ", ymin: " << ymin << ", xmax: " << xmax << ", ymax" << ymax << "\n";
+    LOG(LOG_NORMAL) << "xmin: " << xmin << ", ymin: " << ymin << ", xmax: " << xmax << ", ymax" << ymax << "\n";
 
-    OGRFeature::DestroyFeature(feat);
     GDALClose(ds);
 
+    if (mtime != 0) {
+        writeExtentCache(shpFile, mtime, xmin, xmax, ymin, ymax);
+    }
+
     return true;
 }
\ No newline at end of file
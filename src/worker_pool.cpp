@@ -0,0 +1,86 @@
+#include <algorithm>
+
+#include "worker_pool.hpp"
+
+WorkerPool::WorkerPool(unsigned int numWorkers) {
+    // At least one worker, never more than the hardware can run
+    unsigned int max_workers = std::thread::hardware_concurrency();
+    if (max_workers == 0) max_workers = 1;  // unknown, be conservative
+    if (numWorkers < 1) numWorkers = 1;
+    if (numWorkers > max_workers) numWorkers = max_workers;
+    num_workers = numWorkers;
+}
+
+void WorkerPool::addTask(std::function<void()> task, size_t costHint) {
+    tasks.push_back({std::move(task), costHint});
+}
+
+size_t WorkerPool::pendingTasks() {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    size_t pending = tasks.size();
+    for (const auto &dq : worker_tasks) {
+        pending += dq.size();
+    }
+    return pending;
+}
+
+void WorkerPool::run() {
+    worker_tasks.assign(num_workers, std::deque<Task>());
+    worker_cost.assign(num_workers, 0);
+
+    // Longest-processing-time-first assignment: sort by cost descending
+    // and give each task to the currently least-loaded worker. Unknown
+    // costs (0) sort last and spread round-robin-ish by the same rule.
+    std::stable_sort(tasks.begin(), tasks.end(),
+                     [](const Task &a, const Task &b) { return a.cost > b.cost; });
+    for (Task &task : tasks) {
+        unsigned int lightest = 0;
+        for (unsigned int i = 1; i < num_workers; ++i) {
+            if (worker_cost[i] < worker_cost[lightest]) lightest = i;
+        }
+        worker_cost[lightest] += task.cost + 1;  // +1 so count ties break too
+        worker_tasks[lightest].push_back(std::move(task));
+    }
+    tasks.clear();
+
+    workers.reserve(num_workers);
+    for (unsigned int i = 0; i < num_workers; ++i) {
+        workers.emplace_back(&WorkerPool::workerLoop, this, i);
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+    workers.clear();
+}
+
+void WorkerPool::workerLoop(unsigned int id) {
+    while (true) {
+        Task task;
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            if (!worker_tasks[id].empty()) {
+                // Own work: take from the front (largest first)
+                task = std::move(worker_tasks[id].front());
+                worker_tasks[id].pop_front();
+                worker_cost[id] -= task.cost + 1;
+            } else {
+                // Steal from the worker with the most outstanding cost,
+                // taking from the back (its smallest remaining task) to
+                // minimize the chance of stealing what it needs next
+                unsigned int victim = num_workers;
+                for (unsigned int i = 0; i < num_workers; ++i) {
+                    if (worker_tasks[i].empty()) continue;
+                    if (victim == num_workers || worker_cost[i] > worker_cost[victim]) {
+                        victim = i;
+                    }
+                }
+                if (victim == num_workers) return;  // all deques drained
+                task = std::move(worker_tasks[victim].back());
+                worker_tasks[victim].pop_back();
+                worker_cost[victim] -= task.cost + 1;
+                // and fall through to run it as our own
+            }
+        }
+        task.fn();
+    }
+}